@@ -0,0 +1,203 @@
+// Microbenchmarks of the token transforms, the relational distance ingest and prompt scoring
+//
+// Build: g++ -std=c++20 -O2 -pthread src/benchmark.cpp -o benchmark -lsqlite3
+// Run:   ./benchmark [--filter <substring>] [--output <file>] [--quick]
+//
+// Every benchmark runs on synthetic token maps over a grid of vocabulary sizes and Zipf skews (see
+// BENCH::synthetic_document), so results do not depend on the local corpus. Results are printed
+// as a table and written as JSON (default processed_data/microbenchmarks.json) for comparison
+// between builds, containers and kernels.
+
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <random>
+#include <thread>
+#include <sqlite3.h>
+
+#include "lib/env.hpp"
+#include "lib/transform.hpp"
+#include "lib/feature.hpp"
+#include "lib/index.hpp"
+#include "lib/bench.hpp"
+
+namespace {
+    struct Options {
+        std::string filter;
+        std::filesystem::path output_path = ENV_HPP::processed_data_path / ("microbenchmarks.json");
+        bool quick = false;
+    };
+
+    // Tokens per synthetic title, roughly a short paper after tokenization
+    const size_t document_tokens = 5000;
+    const size_t prompt_tokens = 60;
+
+    // The token transforms on one title, over the std::map the pipeline uses and flatter alternatives
+    void benchmark_transforms(BENCH::Harness& harness, const json& params, const std::map<std::string, int>& document) {
+        std::unordered_map<std::string, int> hashed(document.begin(), document.end());
+        std::vector<std::pair<std::string, int>> sorted(document.begin(), document.end());
+        std::vector<int> counts;
+        for (const auto& [term, count] : document) counts.push_back(count);
+
+        harness.run("compute_sum_token_json", params, [&]() { BENCH::do_not_optimize(TRANSFORMER::compute_sum_token_json(document)); });
+        harness.run("Pythagoras", params, [&]() { BENCH::do_not_optimize(TRANSFORMER::Pythagoras(document)); });
+        harness.run("Pythagoras/unordered_map", params, [&]() {
+            double result = 0.0;
+            for (const auto& [term, count] : hashed) result += count * count;
+            BENCH::do_not_optimize(std::sqrt(result));
+        });
+        harness.run("Pythagoras/sorted_vector", params, [&]() {
+            double result = 0.0;
+            for (const auto& [term, count] : sorted) result += count * count;
+            BENCH::do_not_optimize(std::sqrt(result));
+        });
+        harness.run("Pythagoras/counts_only", params, [&]() {
+            double result = 0.0;
+            for (int count : counts) result += count * count;
+            BENCH::do_not_optimize(std::sqrt(result));
+        });
+        const double distance = TRANSFORMER::Pythagoras(document);
+        harness.run("token_filter", params, [&]() {
+            BENCH::do_not_optimize(TRANSFORMER::token_filter(document, ENV_HPP::max_length, ENV_HPP::min_value, distance));
+        });
+    }
+
+    // Parsing a token file, as computeRelationalDistance does for every title
+    void benchmark_json_to_map(BENCH::Harness& harness, const json& params, const std::map<std::string, int>& document) {
+        if (!harness.selected("json_to_map")) return;
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / ("study_benchmark_json_to_map.json");
+        std::ofstream(file) << json(document).dump(4);
+        harness.run("json_to_map", params, [&]() { BENCH::do_not_optimize(TRANSFORMER::json_to_map(file)); });
+        std::filesystem::remove(file);
+    }
+
+    // The inner loop of computeRelationalDistance: filter, compute and insert one title
+    void benchmark_ingest(BENCH::Harness& harness, const json& params, const std::map<std::string, int>& document) {
+        if (!harness.selected("ingest_token_map")) return;
+        sqlite3* db;
+        if (sqlite3_open(":memory:", &db) != SQLITE_OK) throw std::runtime_error(std::string("Error opening database: ") + sqlite3_errmsg(db));
+        FEATURE::create_relational_tables(db);
+        FEATURE::execute_sql(db, "BEGIN TRANSACTION;");
+        size_t title = 0;
+        harness.run("ingest_token_map", params, [&]() {
+            BENCH::do_not_optimize(FEATURE::ingest_token_map(db, "title_" + std::to_string(title++), document));
+        });
+        FEATURE::execute_sql(db, "COMMIT TRANSACTION;");
+        sqlite3_close(db);
+    }
+
+    /**
+     * Prompt scoring over num_titles synthetic titles: the map-of-maps loop of FEATURE::processPrompt
+     * against INDEX::score_prompt on the equivalent inverted index.
+     */
+    void benchmark_scoring(BENCH::Harness& harness, json params, const BENCH::ZipfSampler& sampler,
+                           std::vector<std::string>& terms, std::mt19937_64& rng, const size_t& num_titles) {
+        if (!harness.selected("prompt_score")) return;
+        params["titles"] = num_titles;
+        std::map<std::string, std::map<std::string, double>> relation_distance_map;
+        INDEX::TitleIndex index;
+        for (size_t t = 0; t < num_titles; ++t) {
+            std::map<std::string, int> document = BENCH::synthetic_document(sampler, document_tokens / 10, rng, terms);
+            const std::string id = std::to_string(t);
+            index.ids.push_back(id);
+            index.file_names.push_back("file_" + id);
+            for (const auto& [token, count, weight] : TRANSFORMER::token_filter(document, ENV_HPP::max_length, ENV_HPP::min_value, TRANSFORMER::Pythagoras(document))) {
+                relation_distance_map["title_" + id][token] = weight;
+                auto [term, inserted] = index.term_ids.try_emplace(token, static_cast<int>(index.terms.size()));
+                if (inserted) {
+                    index.terms.push_back(token);
+                    index.postings.emplace_back();
+                }
+                index.postings[term->second].push_back({static_cast<int>(t), weight});
+            }
+        }
+        std::map<std::string, int> prompt = BENCH::synthetic_document(sampler, prompt_tokens, rng, terms);
+        std::vector<std::tuple<std::string, int, double>> filtered_tokens = TRANSFORMER::token_filter(prompt, 16, 1, TRANSFORMER::Pythagoras(prompt));
+
+        harness.run("prompt_score/map_of_maps", params, [&]() {
+            std::vector<std::tuple<std::string, std::string, double>> results;
+            for (size_t t = 0; t < index.num_docs(); ++t) {
+                double total_distance = 0;
+                for (const auto& entry : filtered_tokens) {
+                    const std::string& token = std::get<0>(entry);
+                    if (relation_distance_map.count("title_" + index.ids[t]) && relation_distance_map["title_" + index.ids[t]].count(token)) {
+                        total_distance += std::get<2>(entry) * relation_distance_map["title_" + index.ids[t]][token];
+                    }
+                }
+                results.push_back({index.ids[t], index.file_names[t], total_distance});
+            }
+            std::sort(results.begin(), results.end(), [](const auto& a, const auto& b) { return std::get<2>(a) > std::get<2>(b); });
+            BENCH::do_not_optimize(results);
+        });
+        harness.run("prompt_score/title_index", params, [&]() {
+            BENCH::do_not_optimize(INDEX::score_prompt(index, prompt, ENV_HPP::default_top_n));
+        });
+    }
+
+    Options parse_options(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--filter" && i + 1 < argc) options.filter = argv[++i];
+            else if (arg == "--output" && i + 1 < argc) options.output_path = argv[++i];
+            else if (arg == "--quick") options.quick = true;
+            else throw std::runtime_error("Invalid option: " + arg + ". Use --filter <substring>, --output <file> or --quick.");
+        }
+        return options;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options = parse_options(argc, argv);
+        BENCH::Harness harness(options.quick ? 5.0 : 20.0, options.quick ? 3 : 7, options.filter);
+        const std::vector<size_t> vocabularies = options.quick ? std::vector<size_t>{10000} : std::vector<size_t>{1000, 10000, 100000};
+        const std::vector<double> skews = options.quick ? std::vector<double>{1.0} : std::vector<double>{0.0, 1.0, 1.5};
+        const size_t num_titles = options.quick ? 200 : 2000;
+
+        for (const size_t& vocabulary : vocabularies) {
+            std::vector<std::string> terms;
+            for (const double& skew : skews) {
+                BENCH::ZipfSampler sampler(vocabulary, skew);
+                std::mt19937_64 rng(vocabulary * 1000 + static_cast<uint64_t>(skew * 10));
+                std::map<std::string, int> document = BENCH::synthetic_document(sampler, document_tokens, rng, terms);
+                json params = {{"vocabulary", vocabulary}, {"skew", skew}, {"unique_tokens", document.size()}};
+
+                benchmark_transforms(harness, params, document);
+                benchmark_json_to_map(harness, params, document);
+                benchmark_ingest(harness, params, document);
+                benchmark_scoring(harness, {{"vocabulary", vocabulary}, {"skew", skew}}, sampler, terms, rng, num_titles);
+            }
+        }
+
+        json context = {
+            {"date", std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()},
+            {"hardware_threads", std::thread::hardware_concurrency()},
+            {"document_tokens", document_tokens},
+            {"quick", options.quick},
+#if defined(__clang__)
+            {"compiler", "clang " __clang_version__},
+#elif defined(__GNUC__)
+            {"compiler", "gcc " __VERSION__},
+#endif
+#ifdef NDEBUG
+            {"assertions", false},
+#else
+            {"assertions", true},
+#endif
+        };
+        if (options.output_path.has_parent_path()) std::filesystem::create_directories(options.output_path.parent_path());
+        std::ofstream out(options.output_path);
+        if (!out) throw std::runtime_error("Could not open " + options.output_path.string());
+        out << harness.to_json(context).dump(4) << std::endl;
+        std::cout << harness.get_results().size() << " benchmarks written to " << options.output_path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
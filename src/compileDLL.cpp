@@ -0,0 +1,263 @@
+// Shared library exposing the engine through a stable C ABI, for in-process calls from Python (ctypes/cffi)
+//
+// Build: g++ -std=c++20 -O2 -shared -fPIC -fvisibility=hidden src/compileDLL.cpp -o study_engine.so -lsqlite3
+//        (on Windows: -o study_engine.dll)
+//
+// Conventions:
+// - Every function that can fail returns a negative value or NULL and sets a per-thread message
+//   readable with study_last_error(); no C++ exception crosses the boundary.
+// - Strings are UTF-8 and NUL-terminated. Strings returned by the library stay valid until the
+//   index they came from is closed (or, for study_last_error, until the next call on that thread).
+// - A StudyIndex may be scored from several threads at once; it must not be closed meanwhile.
+// - New functions may be added; existing signatures only change with STUDY_ABI_VERSION.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <exception>
+#include <sqlite3.h>
+
+#include "lib/env.hpp"
+#include "lib/feature.hpp"
+#include "lib/index.hpp"
+#include "lib/shmring.hpp"
+
+#if defined(_WIN32)
+#define STUDY_API extern "C" __declspec(dllexport)
+#else
+#define STUDY_API extern "C" __attribute__((visibility("default")))
+#endif
+
+#define STUDY_ABI_VERSION 1
+
+// Opaque to callers
+struct StudyIndex {
+    INDEX::TitleIndex index;
+};
+
+// Producer side of the shared memory ring consumed by --ingestring (Linux only)
+struct StudyRing {
+#ifdef __linux__
+    SHMRING::Ring ring;
+#endif
+};
+
+namespace {
+    thread_local std::string last_error;
+
+    // Run fn, turning an exception into last_error and the given failure value
+    template <typename Fn, typename Result>
+    Result guarded(const Fn& fn, const Result& failure) {
+        try {
+            last_error.clear();
+            return fn();
+        } catch (const std::exception& e) {
+            last_error = e.what();
+        } catch (...) {
+            last_error = "Unknown error";
+        }
+        return failure;
+    }
+
+    sqlite3* open_database(const char* database_path) {
+        if (!database_path) throw std::runtime_error("No database path given");
+        sqlite3* db;
+        if (sqlite3_open(database_path, &db) != SQLITE_OK) {
+            std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            throw std::runtime_error(message);
+        }
+        // Callers ingest while their own threads still read pdf_chunks; wait for those reads instead of failing
+        sqlite3_busy_timeout(db, 5000);
+        return db;
+    }
+}
+
+STUDY_API int32_t study_abi_version() {
+    return STUDY_ABI_VERSION;
+}
+
+// Message of the last failure on the calling thread, or "" if the last call succeeded
+STUDY_API const char* study_last_error() {
+    return last_error.c_str();
+}
+
+// Load the title index of the database at database_path; NULL on failure
+STUDY_API StudyIndex* study_index_open(const char* database_path) {
+    return guarded([&]() {
+        sqlite3* db = open_database(database_path);
+        StudyIndex* handle = new StudyIndex();
+        try {
+            handle->index = INDEX::load_title_index(db);
+        } catch (...) {
+            delete handle;
+            sqlite3_close(db);
+            throw;
+        }
+        sqlite3_close(db);
+        return handle;
+    }, static_cast<StudyIndex*>(nullptr));
+}
+
+STUDY_API void study_index_close(StudyIndex* handle) {
+    delete handle;
+}
+
+STUDY_API int64_t study_index_num_docs(const StudyIndex* handle) {
+    return handle ? static_cast<int64_t>(handle->index.num_docs()) : -1;
+}
+
+// The index generation, which changes whenever relation_distance is recomputed
+STUDY_API int64_t study_index_generation(const StudyIndex* handle) {
+    return handle ? handle->index.generation : -1;
+}
+
+// file_info id of a document, or NULL if doc is out of range
+STUDY_API const char* study_doc_id(const StudyIndex* handle, int32_t doc) {
+    if (!handle || doc < 0 || static_cast<size_t>(doc) >= handle->index.num_docs()) return nullptr;
+    return handle->index.ids[doc].c_str();
+}
+
+// file_info file_name of a document, or NULL if doc is out of range
+STUDY_API const char* study_doc_name(const StudyIndex* handle, int32_t doc) {
+    if (!handle || doc < 0 || static_cast<size_t>(doc) >= handle->index.num_docs()) return nullptr;
+    return handle->index.file_names[doc].c_str();
+}
+
+/**
+ * Score a prompt given as num_terms (term, count) pairs, the contents of buffer.json.
+ *
+ * out_docs and out_scores must hold top_n entries each; they receive the documents in descending
+ * order of score. Returns the number of results written, or -1 on failure.
+ */
+STUDY_API int32_t study_score_prompt(const StudyIndex* handle,
+                                     const char* const* terms,
+                                     const int32_t* counts,
+                                     int32_t num_terms,
+                                     int32_t top_n,
+                                     int32_t* out_docs,
+                                     double* out_scores) {
+    return guarded([&]() {
+        if (!handle) throw std::runtime_error("No index given");
+        if (num_terms < 0 || top_n < 0 || (num_terms > 0 && (!terms || !counts)) || (top_n > 0 && (!out_docs || !out_scores))) {
+            throw std::runtime_error("Invalid arguments");
+        }
+        std::map<std::string, int> tokens;
+        for (int32_t i = 0; i < num_terms; ++i) {
+            if (terms[i]) tokens[terms[i]] += counts[i];
+        }
+        std::vector<std::pair<int, double>> results = INDEX::score_prompt(handle->index, tokens, top_n);
+        for (size_t i = 0; i < results.size(); ++i) {
+            out_docs[i] = results[i].first;
+            out_scores[i] = results[i].second;
+        }
+        return static_cast<int32_t>(results.size());
+    }, int32_t{-1});
+}
+
+/**
+ * Insert the token maps of num_titles titles into file_token and relation_distance in one transaction.
+ *
+ * Title t is named title_names[t] (e.g. "title_<id>") and owns the (term, count) pairs
+ * [term_offsets[t], term_offsets[t + 1]) of terms/counts, so term_offsets has num_titles + 1
+ * entries. Tokens are filtered as in computeRelationalDistance. With reset_tables nonzero the
+ * tables are recreated first. Returns the number of relation_distance rows inserted, or -1.
+ */
+STUDY_API int64_t study_ingest_token_maps(const char* database_path,
+                                          const char* const* title_names,
+                                          const int64_t* term_offsets,
+                                          const char* const* terms,
+                                          const int32_t* counts,
+                                          int32_t num_titles,
+                                          int32_t reset_tables) {
+    return guarded([&]() {
+        if (num_titles < 0 || (num_titles > 0 && (!title_names || !term_offsets || !terms || !counts))) {
+            throw std::runtime_error("Invalid arguments");
+        }
+        sqlite3* db = open_database(database_path);
+        int64_t inserted = 0;
+        try {
+            FEATURE::execute_sql(db, "PRAGMA synchronous = OFF;");
+            if (reset_tables) FEATURE::create_relational_tables(db);
+            FEATURE::execute_sql(db, "BEGIN TRANSACTION;");
+            try {
+                for (int32_t t = 0; t < num_titles; ++t) {
+                    std::map<std::string, int> token_map;
+                    for (int64_t i = term_offsets[t]; i < term_offsets[t + 1]; ++i) {
+                        if (terms[i]) token_map[terms[i]] += counts[i];
+                    }
+                    inserted += static_cast<int64_t>(FEATURE::ingest_token_map(db, title_names[t], std::move(token_map)).filtered_tokens.size());
+                }
+                FEATURE::bump_generation(db);
+                FEATURE::execute_sql(db, "COMMIT TRANSACTION;");
+            } catch (...) {
+                sqlite3_exec(db, "ROLLBACK TRANSACTION;", nullptr, nullptr, nullptr);
+                throw;
+            }
+            FEATURE::execute_sql(db, "PRAGMA synchronous = FULL;");
+        } catch (...) {
+            sqlite3_close(db);
+            throw;
+        }
+        sqlite3_close(db);
+        return inserted;
+    }, int64_t{-1});
+}
+
+// Attach to the ring created by a running --ingestring consumer; NULL on failure
+STUDY_API StudyRing* study_ring_attach(const char* name) {
+    return guarded([&]() {
+#ifdef __linux__
+        if (!name) throw std::runtime_error("No ring name given");
+        return new StudyRing{SHMRING::Ring::attach(name)};
+#else
+        throw std::runtime_error("Shared memory ingest requires Linux");
+        return static_cast<StudyRing*>(nullptr);
+#endif
+    }, static_cast<StudyRing*>(nullptr));
+}
+
+STUDY_API void study_ring_close(StudyRing* ring) {
+    delete ring;
+}
+
+/**
+ * Copy one title's num_terms (term, count) pairs into the ring.
+ *
+ * Blocks while the ring is full, for at most timeout_ms (forever if negative). Returns 1 once the
+ * title is published, 0 on timeout, or -1 on failure. Terms longer than 255 bytes are dropped.
+ */
+STUDY_API int32_t study_ring_push_title(StudyRing* ring,
+                                        const char* title_name,
+                                        const char* const* terms,
+                                        const int32_t* counts,
+                                        int32_t num_terms,
+                                        int32_t timeout_ms) {
+    return guarded([&]() {
+        if (!ring || !title_name || num_terms < 0 || (num_terms > 0 && (!terms || !counts))) {
+            throw std::runtime_error("Invalid arguments");
+        }
+#ifdef __linux__
+        std::vector<std::pair<std::string_view, int32_t>> pairs;
+        pairs.reserve(static_cast<size_t>(num_terms));
+        for (int32_t i = 0; i < num_terms; ++i) {
+            if (terms[i]) pairs.push_back({terms[i], counts[i]});
+        }
+        return static_cast<int32_t>(ring->ring.push_title(title_name, pairs, timeout_ms));
+#else
+        return int32_t{-1};
+#endif
+    }, int32_t{-1});
+}
+
+// Tell the consumer this producer has pushed all its titles; 0, or -1 on failure
+STUDY_API int32_t study_ring_finish(StudyRing* ring) {
+    return guarded([&]() {
+        if (!ring) throw std::runtime_error("No ring given");
+#ifdef __linux__
+        ring->ring.push_end();
+#endif
+        return int32_t{0};
+    }, int32_t{-1});
+}
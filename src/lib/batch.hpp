@@ -0,0 +1,106 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "cache.hpp"
+#include "parallel.hpp"
+
+namespace BATCH {
+
+    // Return the given percentile (0-100) of an ascending sorted vector using the nearest-rank method
+    double percentile(const std::vector<double>& sorted_values, const double& p) {
+        if (sorted_values.empty()) return 0.0;
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted_values.size()));
+        return sorted_values[std::clamp<size_t>(rank, 1, sorted_values.size()) - 1];
+    }
+
+    /**
+     * @brief Score every prompt of a JSONL file against one shared index and write the top results as JSONL
+     *
+     * Each input line is a prompt request as accepted by the query server: a plain token map or
+     * {"$request": "prompt", "tokens": {...}, "top_n": 10}, optionally carrying a "query_id" that is copied to the output.
+     * Prompts are scored in parallel and repeated prompts are answered from a shared result cache;
+     * output lines keep the input order. Throughput and latency
+     * percentiles are printed once all prompts have been scored.
+     *
+     * @param input_path The JSONL file of prompts
+     * @param output_path The JSONL file to write the results to
+     * @param num_threads The number of scoring threads
+     */
+    void processBatchPrompts(const std::filesystem::path& input_path,
+                             const std::filesystem::path& output_path,
+                             const unsigned int& num_threads = PARALLEL::default_threads()) {
+        try {
+            std::ifstream input(input_path);
+            if (!input.is_open()) {
+                std::cerr << "Could not open batch prompt file: " << input_path << std::endl;
+                return;
+            }
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);) {
+                if (!line.empty()) lines.push_back(line);
+            }
+
+            INDEX::TitleIndex index = INDEX::load_title_index();
+            std::cout << "Loaded " << index.num_docs() << " titles and " << index.num_terms() << " terms" << std::endl;
+
+            CACHE::ResultCache cache(ENV_HPP::result_cache_capacity);
+            std::vector<std::string> responses(lines.size());
+            std::vector<double> latencies_us(lines.size(), 0.0);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            PARALLEL::parallel_for(lines.size(), [&](size_t begin, size_t end, unsigned int) {
+                for (size_t i = begin; i < end; ++i) {
+                    std::chrono::time_point<std::chrono::steady_clock> query_start = std::chrono::steady_clock::now();
+                    json response;
+                    try {
+                        json request = json::parse(lines[i]);
+                        if (request.contains("query_id")) response["query_id"] = request["query_id"];
+                        INDEX::PromptRequest prompt = INDEX::parse_prompt_request(request);
+                        response["results"] = INDEX::results_to_json(index, CACHE::score_prompt(cache, index, prompt.tokens, prompt.top_n));
+                    } catch (const std::exception& e) {
+                        response["error"] = e.what();
+                    }
+                    response["line"] = i + 1;
+                    responses[i] = response.dump();
+                    latencies_us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - query_start).count();
+                }
+            }, num_threads);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::ofstream output(output_path);
+            if (!output.is_open()) {
+                std::cerr << "Could not open batch result file: " << output_path << std::endl;
+                return;
+            }
+            for (const std::string& response : responses) {
+                output << response << '\n';
+            }
+
+            std::sort(latencies_us.begin(), latencies_us.end());
+            std::cout << "Scored " << lines.size() << " prompts with " << num_threads << " threads in " << elapsed.count() << " seconds" << std::endl
+                      << "Throughput: " << (elapsed.count() > 0 ? lines.size() / elapsed.count() : 0.0) << " queries/second" << std::endl
+                      << "Latency (us): p50 " << percentile(latencies_us, 50)
+                      << ", p90 " << percentile(latencies_us, 90)
+                      << ", p99 " << percentile(latencies_us, 99)
+                      << ", max " << percentile(latencies_us, 100) << std::endl
+                      << "Cache: " << cache.get_stats().to_json().dump() << std::endl
+                      << "Results written to " << output_path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // BATCH_HPP
@@ -0,0 +1,191 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace BENCH {
+
+    // Keep value observable so the computation producing it is not optimised away
+    template <typename T>
+    void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    // Timing of one benchmark, per operation
+    struct Result {
+        std::string name;
+        json params;
+        uint64_t iterations = 0;   // Per sample
+        size_t samples = 0;
+        double median_ns = 0.0;
+        double min_ns = 0.0;
+        double mean_ns = 0.0;
+    };
+
+    /**
+     * @brief Runs benchmarks and collects their results
+     *
+     * Each benchmark is calibrated by doubling its iteration count until one sample takes at least
+     * min_sample_ms, then timed over a fixed number of samples; the median is the headline figure,
+     * as it is the least sensitive to interference. Benchmarks whose name does not contain filter
+     * are skipped.
+     */
+    class Harness {
+    public:
+        Harness(const double& min_sample_ms = 20.0, const size_t& num_samples = 7, const std::string& filter = "")
+            : min_sample_ms(min_sample_ms), num_samples(num_samples), filter(filter) {}
+
+        bool selected(const std::string& name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        // Time fn(), one operation per call
+        template <typename Fn>
+        void run(const std::string& name, const json& params, const Fn& fn) {
+            if (!selected(name)) return;
+            uint64_t iterations = 1;
+            while (true) {
+                double ns = sample(fn, iterations);
+                if (ns >= min_sample_ms * 1e6 || iterations >= (uint64_t{1} << 30)) break;
+                // Jump close to the target once the sample is long enough to extrapolate from
+                iterations = (ns > 1e6) ? static_cast<uint64_t>(iterations * (min_sample_ms * 1e6 / ns) * 1.1) + 1 : iterations * 2;
+            }
+            std::vector<double> per_op;
+            for (size_t s = 0; s < num_samples; ++s) per_op.push_back(sample(fn, iterations) / static_cast<double>(iterations));
+            std::sort(per_op.begin(), per_op.end());
+
+            Result result = {
+                .name = name,
+                .params = params,
+                .iterations = iterations,
+                .samples = per_op.size(),
+                .median_ns = per_op[per_op.size() / 2],
+                .min_ns = per_op.front(),
+                .mean_ns = std::accumulate(per_op.begin(), per_op.end(), 0.0) / static_cast<double>(per_op.size()),
+            };
+            std::cout << std::left << std::setw(32) << name << std::setw(60) << params.dump() << std::right
+                      << std::setw(14) << std::fixed << std::setprecision(1) << result.median_ns << " ns/op"
+                      << std::setw(12) << iterations << " iterations" << std::defaultfloat << std::endl;
+            results.push_back(std::move(result));
+        }
+
+        const std::vector<Result>& get_results() const { return results; }
+
+        // {"context": context, "benchmarks": [{name, params, iterations, samples, median_ns, min_ns, mean_ns}]}
+        json to_json(const json& context) const {
+            json benchmarks = json::array();
+            for (const Result& result : results) {
+                benchmarks.push_back({
+                    {"name", result.name},
+                    {"params", result.params},
+                    {"iterations", result.iterations},
+                    {"samples", result.samples},
+                    {"median_ns", result.median_ns},
+                    {"min_ns", result.min_ns},
+                    {"mean_ns", result.mean_ns},
+                });
+            }
+            return {{"context", context}, {"benchmarks", benchmarks}};
+        }
+
+    private:
+        double min_sample_ms;
+        size_t num_samples;
+        std::string filter;
+        std::vector<Result> results;
+
+        template <typename Fn>
+        static double sample(const Fn& fn, const uint64_t& iterations) {
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) fn();
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    /**
+     * @brief The term of the given frequency rank in a synthetic vocabulary
+     *
+     * Terms are mostly 3 to 16 lowercase letters, so some exceed ENV_HPP::max_length, and every
+     * 17th term ends in a digit, so the token filters have something to reject as on real text.
+     */
+    std::string synthetic_term(const size_t& rank) {
+        uint64_t state = rank * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull;
+        auto next = [&]() {
+            state ^= state >> 31;
+            state *= 0xBF58476D1CE4E5B9ull;
+            state ^= state >> 29;
+            return state;
+        };
+        std::string term;
+        size_t length = 3 + next() % 14;
+        // The rank in base 26 keeps terms (nearly always) distinct; the remaining letters are pseudo-random
+        for (size_t r = rank; r > 0 || term.size() < length; r /= 26) {
+            term += static_cast<char>('a' + (r > 0 ? r % 26 : next() % 26));
+        }
+        if (rank % 17 == 16) term.back() = static_cast<char>('0' + rank % 10);
+        return term;
+    }
+
+    /**
+     * @brief Draws term ranks from a Zipf distribution, P(rank k) proportional to 1 / (k + 1)^skew
+     *
+     * skew 0 is uniform; natural-language text is close to 1.
+     */
+    class ZipfSampler {
+    public:
+        ZipfSampler(const size_t& vocabulary, const double& skew) : cumulative(vocabulary) {
+            double total = 0.0;
+            for (size_t k = 0; k < vocabulary; ++k) {
+                total += 1.0 / std::pow(static_cast<double>(k + 1), skew);
+                cumulative[k] = total;
+            }
+            for (double& c : cumulative) c /= total;
+        }
+
+        template <typename Rng>
+        size_t operator()(Rng& rng) const {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            return std::min<size_t>(std::lower_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin(), cumulative.size() - 1);
+        }
+
+        size_t vocabulary() const { return cumulative.size(); }
+
+    private:
+        std::vector<double> cumulative;
+    };
+
+    /**
+     * @brief Token counts of a synthetic document of num_tokens tokens, as the tokenizer writes them
+     *
+     * terms caches synthetic_term() by rank and is filled on demand.
+     */
+    template <typename Rng>
+    std::map<std::string, int> synthetic_document(const ZipfSampler& sampler, const size_t& num_tokens, Rng& rng, std::vector<std::string>& terms) {
+        if (terms.size() < sampler.vocabulary()) {
+            for (size_t k = terms.size(); k < sampler.vocabulary(); ++k) terms.push_back(synthetic_term(k));
+        }
+        std::map<std::string, int> document;
+        for (size_t t = 0; t < num_tokens; ++t) ++document[terms[sampler(rng)]];
+        return document;
+    }
+}
+
+#endif // BENCH_HPP
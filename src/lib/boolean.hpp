@@ -0,0 +1,403 @@
+#ifndef BOOLEAN_HPP
+#define BOOLEAN_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "env.hpp"
+#include "index.hpp"
+#include "tokenizer.hpp"
+
+namespace BOOLEAN {
+
+    // Size ratio above which galloping beats a linear merge; measured with --benchmarkintersection
+#if defined(__AVX2__)
+    const size_t gallop_ratio = 512;
+#else
+    const size_t gallop_ratio = 16;
+#endif
+
+    // Sorted document ids of every term of a title index
+    struct DocLists {
+        std::vector<std::vector<uint32_t>> docs;
+        size_t num_docs = 0;
+    };
+
+    DocLists build_doc_lists(const INDEX::TitleIndex& index) {
+        DocLists lists;
+        lists.num_docs = index.num_docs();
+        lists.docs.resize(index.num_terms());
+        for (size_t t = 0; t < index.num_terms(); ++t) {
+            lists.docs[t].reserve(index.postings[t].size());
+            for (const INDEX::Posting& posting : index.postings[t]) {
+                lists.docs[t].push_back(static_cast<uint32_t>(posting.doc));
+            }
+        }
+        return lists;
+    }
+
+    // Branch-light merge intersection of two sorted lists
+    std::vector<uint32_t> intersect_scalar(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        std::vector<uint32_t> out;
+        out.reserve(std::min(a.size(), b.size()));
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            uint32_t x = a[i], y = b[j];
+            if (x == y) out.push_back(x);
+            i += (x <= y);
+            j += (y <= x);
+        }
+        return out;
+    }
+
+    // Intersection for skewed sizes: every element of the short list gallops through the long list
+    std::vector<uint32_t> intersect_gallop(const std::vector<uint32_t>& small, const std::vector<uint32_t>& large) {
+        std::vector<uint32_t> out;
+        out.reserve(small.size());
+        const uint32_t* cursor = large.data();
+        const uint32_t* end = large.data() + large.size();
+        for (uint32_t x : small) {
+            cursor = INDEX::gallop(cursor, end, x);
+            if (cursor == end) break;
+            if (*cursor == x) out.push_back(x);
+        }
+        return out;
+    }
+
+#if defined(__AVX2__)
+    /**
+     * @brief AVX2 intersection: each element of the shorter list is compared against 8 elements of the
+     * longer list at once
+     *
+     * Blocks of the longer list whose last element is below the probe are skipped whole, so the loop
+     * does one vector compare per probe plus one scalar compare per skipped block.
+     */
+    std::vector<uint32_t> intersect_avx2(const std::vector<uint32_t>& small, const std::vector<uint32_t>& large) {
+        std::vector<uint32_t> out;
+        out.reserve(small.size());
+        size_t i = 0, j = 0;
+        const size_t blocks = large.size() & ~static_cast<size_t>(7);
+        for (; i < small.size() && j < blocks; ++i) {
+            uint32_t x = small[i];
+            while (j < blocks && large[j + 7] < x) j += 8;
+            if (j == blocks) break;
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(large.data() + j));
+            __m256i hit = _mm256_cmpeq_epi32(block, _mm256_set1_epi32(static_cast<int>(x)));
+            if (!_mm256_testz_si256(hit, hit)) out.push_back(x);
+        }
+        // Scalar tail over the last partial block
+        for (; i < small.size() && j < large.size(); ) {
+            if (small[i] == large[j]) { out.push_back(small[i]); ++i; ++j; }
+            else if (small[i] < large[j]) ++i;
+            else ++j;
+        }
+        return out;
+    }
+#endif
+
+    const char* kernel_name() {
+#if defined(__AVX2__)
+        return "avx2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Intersect two sorted lists, choosing galloping for skewed sizes and a linear kernel otherwise
+    std::vector<uint32_t> intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        const std::vector<uint32_t>& small = (a.size() <= b.size()) ? a : b;
+        const std::vector<uint32_t>& large = (a.size() <= b.size()) ? b : a;
+        if (small.empty()) return {};
+        if (large.size() / small.size() >= gallop_ratio) return intersect_gallop(small, large);
+#if defined(__AVX2__)
+        return intersect_avx2(small, large);
+#else
+        return intersect_scalar(small, large);
+#endif
+    }
+
+    std::vector<uint32_t> unite(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        std::vector<uint32_t> out;
+        out.reserve(a.size() + b.size());
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        return out;
+    }
+
+    std::vector<uint32_t> subtract(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        std::vector<uint32_t> out;
+        out.reserve(a.size());
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        return out;
+    }
+
+    /**
+     * @brief A set of documents, either listed or given by its complement
+     *
+     * Keeping NOT symbolic lets "X AND NOT Y" run as a difference instead of materializing every
+     * document that does not contain Y.
+     */
+    struct DocSet {
+        std::vector<uint32_t> docs;
+        bool negated = false;
+    };
+
+    DocSet set_and(const DocSet& a, const DocSet& b) {
+        if (!a.negated && !b.negated) return {intersect(a.docs, b.docs), false};
+        if (!a.negated) return {subtract(a.docs, b.docs), false};
+        if (!b.negated) return {subtract(b.docs, a.docs), false};
+        return {unite(a.docs, b.docs), true};
+    }
+
+    DocSet set_or(const DocSet& a, const DocSet& b) {
+        if (!a.negated && !b.negated) return {unite(a.docs, b.docs), false};
+        if (!a.negated) return {subtract(b.docs, a.docs), true};
+        if (!b.negated) return {subtract(a.docs, b.docs), true};
+        return {intersect(a.docs, b.docs), true};
+    }
+
+    // Expand a set into explicit document ids out of num_docs documents
+    std::vector<uint32_t> materialize(const DocSet& set, const size_t& num_docs) {
+        if (!set.negated) return set.docs;
+        std::vector<uint32_t> out;
+        out.reserve(num_docs - set.docs.size());
+        size_t j = 0;
+        for (uint32_t doc = 0; doc < num_docs; ++doc) {
+            if (j < set.docs.size() && set.docs[j] == doc) ++j;
+            else out.push_back(doc);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Recursive descent evaluator for filter expressions
+     *
+     * Grammar, with operators matched case-insensitively and AND binding tighter than OR:
+     *   expr    := and_expr ("OR" and_expr)*
+     *   and_expr:= unary ("AND" unary)*
+     *   unary   := "NOT" unary | "(" expr ")" | word
+     * A word matches the titles whose vocabulary contains it, either as written or once stemmed.
+     */
+    class FilterParser {
+    public:
+        FilterParser(const INDEX::TitleIndex& index, const DocLists& lists, const std::string& text)
+            : index(index), lists(lists) {
+            std::string current;
+            for (char c : text) {
+                if (c == '(' || c == ')' || std::isspace(static_cast<unsigned char>(c))) {
+                    if (!current.empty()) tokens.push_back(current);
+                    current.clear();
+                    if (c == '(' || c == ')') tokens.push_back(std::string(1, c));
+                } else {
+                    current.push_back(c);
+                }
+            }
+            if (!current.empty()) tokens.push_back(current);
+        }
+
+        DocSet parse() {
+            DocSet result = expr();
+            if (position < tokens.size()) {
+                throw std::runtime_error("Unexpected '" + tokens[position] + "' in filter");
+            }
+            return result;
+        }
+
+    private:
+        const INDEX::TitleIndex& index;
+        const DocLists& lists;
+        std::vector<std::string> tokens;
+        size_t position = 0;
+
+        bool accept(const std::string& keyword) {
+            if (position >= tokens.size() || tokens[position].size() != keyword.size()) return false;
+            for (size_t i = 0; i < keyword.size(); ++i) {
+                if (std::toupper(static_cast<unsigned char>(tokens[position][i])) != keyword[i]) return false;
+            }
+            ++position;
+            return true;
+        }
+
+        DocSet expr() {
+            DocSet result = and_expr();
+            while (accept("OR")) result = set_or(result, and_expr());
+            return result;
+        }
+
+        DocSet and_expr() {
+            DocSet result = unary();
+            while (accept("AND")) result = set_and(result, unary());
+            return result;
+        }
+
+        DocSet unary() {
+            if (accept("NOT")) {
+                DocSet result = unary();
+                result.negated = !result.negated;
+                return result;
+            }
+            if (accept("(")) {
+                DocSet result = expr();
+                if (!accept(")")) throw std::runtime_error("Missing ')' in filter");
+                return result;
+            }
+            if (position >= tokens.size() || tokens[position] == ")") {
+                throw std::runtime_error("Missing term in filter");
+            }
+            return word(tokens[position++]);
+        }
+
+        DocSet word(const std::string& text) {
+            std::string lower = text;
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+            int term = index.find_term(lower);
+            if (term < 0) {
+                std::vector<std::string> stemmed = TOKENIZER::tokenize(lower, false);
+                if (!stemmed.empty()) term = index.find_term(stemmed.front());
+            }
+            return (term < 0) ? DocSet{} : DocSet{lists.docs[term], false};
+        }
+    };
+
+    /**
+     * @brief Rank only the titles that satisfy the filter
+     *
+     * Each posting list is intersected with the surviving documents, galloping the shorter of the two
+     * through the longer, so postings of filtered-out titles are skipped rather than scored.
+     *
+     * @param docs The sorted surviving document ids
+     * @return (document, score) pairs in descending order of score, ties broken by document order
+     */
+    std::vector<std::pair<int, double>> score_filtered(const INDEX::TitleIndex& index,
+                                                       const std::map<std::string, int>& tokens,
+                                                       const std::vector<uint32_t>& docs,
+                                                       const int& top_n = 100) {
+        auto before_doc = [](const INDEX::Posting& posting, const uint32_t& doc) { return static_cast<uint32_t>(posting.doc) < doc; };
+        std::vector<double> scores(docs.size(), 0.0);  // Indexed by position in docs
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = index.find_term(token);
+            if (term < 0) continue;
+            const std::vector<INDEX::Posting>& list = index.postings[term];
+            if (docs.size() <= list.size()) {
+                auto cursor = list.begin();
+                for (size_t i = 0; i < docs.size() && cursor != list.end(); ++i) {
+                    cursor = INDEX::gallop(cursor, list.end(), docs[i], before_doc);
+                    if (cursor != list.end() && static_cast<uint32_t>(cursor->doc) == docs[i]) scores[i] += weight * cursor->weight;
+                }
+            } else {
+                auto cursor = docs.begin();
+                for (const INDEX::Posting& posting : list) {
+                    cursor = INDEX::gallop(cursor, docs.end(), static_cast<uint32_t>(posting.doc));
+                    if (cursor == docs.end()) break;
+                    if (*cursor == static_cast<uint32_t>(posting.doc)) scores[cursor - docs.begin()] += weight * posting.weight;
+                }
+            }
+        }
+        std::vector<std::pair<int, double>> result;
+        result.reserve(docs.size());
+        for (size_t i = 0; i < docs.size(); ++i) result.push_back({static_cast<int>(docs[i]), scores[i]});
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(keep);
+        return result;
+    }
+
+    /**
+     * @brief Process buffer.json with a boolean filter
+     *
+     * buffer.json is either a plain token map or {"$request": "prompt", "tokens": {...}, "top_n": 10, "filter": "X AND (Y OR Z) AND NOT W"}.
+     */
+    void processPrompt() {
+        try {
+            std::ifstream file(ENV_HPP::buffer_json_path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open JSON file: " + ENV_HPP::buffer_json_path.string());
+            }
+            json request;
+            file >> request;
+            INDEX::PromptRequest prompt = INDEX::parse_prompt_request(request);
+            std::string filter = INDEX::is_envelope(request) ? request.value("filter", std::string()) : std::string();
+
+            INDEX::TitleIndex index = INDEX::load_title_index();
+            DocLists lists = build_doc_lists(index);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            DocSet set = filter.empty() ? DocSet{{}, true} : FilterParser(index, lists, filter).parse();
+            std::vector<uint32_t> docs = materialize(set, index.num_docs());
+            std::chrono::duration<double, std::micro> filter_us = std::chrono::steady_clock::now() - start;
+
+            std::vector<std::pair<int, double>> results = score_filtered(index, prompt.tokens, docs, prompt.top_n);
+            INDEX::print_results(index, results);
+            std::cout << "Filter: " << (filter.empty() ? "(none)" : filter) << std::endl
+                      << docs.size() << " of " << index.num_docs() << " titles match, filtered in "
+                      << filter_us.count() << " us (" << kernel_name() << " intersection)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Sorted random document ids in [0, universe)
+    std::vector<uint32_t> random_list(std::mt19937& rng, const size_t& size, const uint32_t& universe) {
+        std::vector<uint32_t> list;
+        list.reserve(size);
+        std::uniform_int_distribution<uint32_t> pick(0, universe - 1);
+        while (list.size() < size) list.push_back(pick(rng));
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        return list;
+    }
+
+    /**
+     * @brief Benchmark the intersection kernels on random lists of increasingly different lengths
+     *
+     * The long list is fixed; the short list shrinks so the size ratio runs from 1 to 4096.
+     * Every kernel's output is checked against the scalar merge.
+     */
+    void benchmarkIntersection(const size_t& long_size = 1 << 20, const int& repeats = 20) {
+        std::mt19937 rng(42);
+        const uint32_t universe = static_cast<uint32_t>(long_size * 4);
+        std::vector<uint32_t> large = random_list(rng, long_size, universe);
+
+        auto time_us = [&](auto&& kernel, const std::vector<uint32_t>& small, std::vector<uint32_t>& found) {
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) found = kernel(small, large);
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+        };
+
+        std::cout << "Long list: " << large.size() << " ids, kernel: " << kernel_name() << std::endl
+                  << "ratio, short size, matches, scalar us, gallop us, simd us, auto us" << std::endl;
+        for (size_t ratio = 1; ratio <= 4096; ratio *= 4) {
+            std::vector<uint32_t> small = random_list(rng, large.size() / ratio, universe);
+            std::vector<uint32_t> expected, found;
+            double scalar_us = time_us(intersect_scalar, small, expected);
+            double gallop_us = time_us(intersect_gallop, small, found);
+            if (found != expected) throw std::runtime_error("Galloping intersection mismatch");
+#if defined(__AVX2__)
+            double simd_us = time_us(intersect_avx2, small, found);
+            if (found != expected) throw std::runtime_error("AVX2 intersection mismatch");
+#else
+            double simd_us = scalar_us;
+#endif
+            double auto_us = time_us(intersect, small, found);
+            if (found != expected) throw std::runtime_error("Intersection mismatch");
+            std::cout << ratio << ", " << small.size() << ", " << expected.size() << ", " << scalar_us << ", "
+                      << gallop_us << ", " << simd_us << ", " << auto_us << std::endl;
+        }
+    }
+}
+
+#endif // BOOLEAN_HPP
@@ -0,0 +1,143 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <sstream>
+#include <nlohmann/json.hpp>
+
+#include "index.hpp"
+
+namespace CACHE {
+
+    /**
+     * @brief Build the canonical cache key of a prompt
+     *
+     * The key is made of the prompt terms that survive INDEX::prompt_weights, in token order, with
+     * their exact weights, followed by top_n. Tokens that are filtered out do not change the key,
+     * so prompts that stem to the same filtered token map share one cache entry.
+     */
+    std::string canonical_key(const std::map<std::string, int>& tokens, const int& top_n) {
+        std::ostringstream key;
+        key << std::hexfloat;
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            key << token << ':' << weight << ';';
+        }
+        key << '#' << top_n;
+        return key.str();
+    }
+
+    // Hit-rate counters of a ResultCache
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+        size_t size = 0;
+
+        double hit_rate() const {
+            uint64_t lookups = hits + misses;
+            return (lookups == 0) ? 0.0 : static_cast<double>(hits) / lookups;
+        }
+
+        json to_json() const {
+            return {{"hits", hits}, {"misses", misses}, {"evictions", evictions},
+                    {"invalidations", invalidations}, {"size", size}, {"hit_rate", hit_rate()}};
+        }
+    };
+
+    /**
+     * @brief Thread-safe LRU cache of scored prompt results for one index generation
+     *
+     * Entries are (document, score) lists, which are only meaningful for the index they were
+     * computed on. Every lookup and insert carries the generation of the index in use; when it
+     * differs from the generation of the cached entries, the whole cache is dropped first.
+     */
+    class ResultCache {
+    public:
+        using Results = std::vector<std::pair<int, double>>;
+
+        explicit ResultCache(size_t capacity) : capacity(capacity) {}
+
+        // Look up a key, returning true and filling results on a hit
+        bool get(const std::string& key, const int64_t& generation, Results& results) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sync_generation(generation);
+            auto it = entries.find(key);
+            if (it == entries.end()) {
+                stats.misses++;
+                return false;
+            }
+            order.splice(order.begin(), order, it->second.position);
+            results = it->second.results;
+            stats.hits++;
+            return true;
+        }
+
+        void put(const std::string& key, const int64_t& generation, const Results& results) {
+            if (capacity == 0) return;
+            std::lock_guard<std::mutex> lock(mutex);
+            sync_generation(generation);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                it->second.results = results;
+                order.splice(order.begin(), order, it->second.position);
+                return;
+            }
+            if (entries.size() >= capacity) {
+                entries.erase(order.back());
+                order.pop_back();
+                stats.evictions++;
+            }
+            order.push_front(key);
+            entries.emplace(key, Entry{results, order.begin()});
+        }
+
+        CacheStats get_stats() {
+            std::lock_guard<std::mutex> lock(mutex);
+            CacheStats result = stats;
+            result.size = entries.size();
+            return result;
+        }
+
+    private:
+        struct Entry {
+            Results results;
+            std::list<std::string>::iterator position;
+        };
+
+        // Drop every entry when the index generation has moved on; called with the mutex held
+        void sync_generation(const int64_t& generation) {
+            if (generation == current_generation) return;
+            if (!entries.empty()) stats.invalidations++;
+            entries.clear();
+            order.clear();
+            current_generation = generation;
+        }
+
+        size_t capacity;
+        int64_t current_generation = -1;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> order; // Most recently used first
+        CacheStats stats;
+        std::mutex mutex;
+    };
+
+    // Score a prompt through the cache, computing and storing the results on a miss
+    ResultCache::Results score_prompt(ResultCache& cache, const INDEX::TitleIndex& index,
+                                      const std::map<std::string, int>& tokens, const int& top_n) {
+        std::string key = canonical_key(tokens, top_n);
+        ResultCache::Results results;
+        if (cache.get(key, index.generation, results)) return results;
+        results = INDEX::score_prompt(index, tokens, top_n);
+        cache.put(key, index.generation, results);
+        return results;
+    }
+}
+
+#endif // CACHE_HPP
@@ -0,0 +1,358 @@
+#ifndef CHUNK_HPP
+#define CHUNK_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "codec.hpp"
+#include "tokenizer.hpp"
+#include "parallel.hpp"
+
+namespace CHUNK {
+
+    const uint32_t index_magic = 0x49434153; // "SACI"
+    const uint32_t index_version = 2;
+
+    /**
+     * @brief Chunk-granularity inverted index over pdf_chunks
+     *
+     * Every row of pdf_chunks is a document, numbered in ascending chunk id order. Posting lists store,
+     * per term, varint pairs of (gap to the previous document, token count) so they stay compact with
+     * ~100x more units than titles; weights are count / L2 norm of the chunk, as for titles.
+     * A forward store of (term, count) pairs per chunk, sorted by term id, allows scoring a chosen
+     * subset of chunks without walking whole posting lists.
+     */
+    struct ChunkIndex {
+        int64_t generation = 0;
+
+        // Titles, from file_info
+        std::vector<std::string> title_ids;
+        std::vector<std::string> title_names;
+        std::vector<int64_t> title_starting_ids;
+        std::vector<int64_t> title_ending_ids;
+
+        // Chunks
+        std::vector<int64_t> chunk_ids;
+        std::vector<int32_t> chunk_titles;   // -1 if the chunk is outside every title's id range
+        std::vector<float> chunk_norms;
+
+        // Vocabulary and postings
+        std::vector<std::string> terms;
+        std::unordered_map<std::string, int> term_ids;
+        std::vector<uint32_t> doc_freqs;
+        std::vector<uint64_t> term_offsets;  // Postings of term t are postings[term_offsets[t], term_offsets[t + 1])
+        std::vector<uint8_t> postings;
+
+        // Forward store: terms of chunk c are chunk_terms/chunk_counts[chunk_offsets[c], chunk_offsets[c + 1])
+        std::vector<uint64_t> chunk_offsets;
+        std::vector<uint32_t> chunk_terms;
+        std::vector<uint16_t> chunk_counts;
+
+        size_t num_chunks() const { return chunk_ids.size(); }
+        size_t num_terms() const { return terms.size(); }
+
+        int find_term(const std::string& token) const {
+            auto it = term_ids.find(token);
+            return (it == term_ids.end()) ? -1 : it->second;
+        }
+    };
+
+    // Title id ranges from file_info, sorted by starting id, used to map chunk ids to titles
+    struct TitleRange {
+        int64_t starting_id;
+        int64_t ending_id;
+        int32_t title;
+    };
+
+    int32_t find_title(const std::vector<TitleRange>& ranges, const int64_t& chunk_id) {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), chunk_id,
+                                   [](int64_t id, const TitleRange& range) { return id < range.starting_id; });
+        if (it == ranges.begin()) return -1;
+        --it;
+        return (chunk_id <= it->ending_id) ? it->title : -1;
+    }
+
+    /**
+     * @brief Build the chunk index from pdf_chunks
+     *
+     * Chunks are read in batches; each batch is tokenized in parallel with the same cleaning and stemming
+     * as word_freq.py, then appended to the posting lists in chunk id order.
+     *
+     * @param db The database connection
+     * @param batch_size The number of chunks tokenized per parallel batch
+     * @return The built index
+     *
+     * @throws std::runtime_error if a query cannot be prepared.
+     */
+    ChunkIndex build_chunk_index(sqlite3* db, const size_t& batch_size = 4096) {
+        ChunkIndex index;
+        index.generation = INDEX::read_generation(db);
+
+        std::vector<TitleRange> ranges;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT id, file_name, starting_id, ending_id FROM file_info;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (file_info): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* id_text = sqlite3_column_text(stmt, 0);
+            const unsigned char* file_name_text = sqlite3_column_text(stmt, 1);
+            if (!id_text || !file_name_text) continue;
+            ranges.push_back({sqlite3_column_int64(stmt, 2), sqlite3_column_int64(stmt, 3), static_cast<int32_t>(index.title_ids.size())});
+            index.title_ids.push_back(reinterpret_cast<const char*>(id_text));
+            index.title_names.push_back(reinterpret_cast<const char*>(file_name_text));
+            index.title_starting_ids.push_back(sqlite3_column_int64(stmt, 2));
+            index.title_ending_ids.push_back(sqlite3_column_int64(stmt, 3));
+        }
+        sqlite3_finalize(stmt);
+        std::sort(ranges.begin(), ranges.end(), [](const TitleRange& a, const TitleRange& b) { return a.starting_id < b.starting_id; });
+
+        if (sqlite3_prepare_v2(db, "SELECT id, chunk_text FROM pdf_chunks ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (pdf_chunks): ") + sqlite3_errmsg(db));
+        }
+
+        std::vector<std::vector<uint8_t>> term_postings;
+        std::vector<uint32_t> last_doc;
+        std::vector<std::string> texts;
+        std::vector<std::map<std::string, int>> counts;
+        std::vector<std::pair<uint32_t, uint16_t>> forward;
+        index.chunk_offsets.push_back(0);
+        bool has_rows = true;
+        while (has_rows) {
+            // Read one batch of chunk texts
+            texts.clear();
+            while (texts.size() < batch_size) {
+                if (sqlite3_step(stmt) != SQLITE_ROW) {
+                    has_rows = false;
+                    break;
+                }
+                const unsigned char* text = sqlite3_column_text(stmt, 1);
+                int64_t chunk_id = sqlite3_column_int64(stmt, 0);
+                index.chunk_ids.push_back(chunk_id);
+                index.chunk_titles.push_back(find_title(ranges, chunk_id));
+                texts.push_back(text ? reinterpret_cast<const char*>(text) : "");
+            }
+
+            // Tokenize the batch in parallel
+            counts.assign(texts.size(), {});
+            PARALLEL::parallel_for(texts.size(), [&](size_t begin, size_t end, unsigned int) {
+                for (size_t i = begin; i < end; ++i) {
+                    for (const auto& [token, count] : TOKENIZER::count_tokens(texts[i])) {
+                        if (token.length() <= static_cast<size_t>(ENV_HPP::max_length)) counts[i][token] = count;
+                    }
+                }
+            });
+
+            // Append the batch to the posting lists, in document order
+            uint32_t first_doc = static_cast<uint32_t>(index.chunk_ids.size() - texts.size());
+            for (size_t i = 0; i < texts.size(); ++i) {
+                uint32_t doc = first_doc + static_cast<uint32_t>(i);
+                double norm = 0.0;
+                forward.clear();
+                for (const auto& [token, count] : counts[i]) {
+                    auto [term, inserted] = index.term_ids.try_emplace(token, static_cast<int>(index.terms.size()));
+                    if (inserted) {
+                        index.terms.push_back(token);
+                        term_postings.emplace_back();
+                        last_doc.push_back(0);
+                        index.doc_freqs.push_back(0);
+                    }
+                    int t = term->second;
+                    // The first posting of a list stores doc + 1 so that every gap is positive
+                    CODEC::encode_varint(term_postings[t], (index.doc_freqs[t] == 0) ? doc + 1 : doc - last_doc[t]);
+                    CODEC::encode_varint(term_postings[t], static_cast<uint64_t>(count));
+                    last_doc[t] = doc;
+                    index.doc_freqs[t]++;
+                    norm += static_cast<double>(count) * count;
+                    forward.push_back({static_cast<uint32_t>(t), static_cast<uint16_t>(std::min(count, 0xFFFF))});
+                }
+                index.chunk_norms.push_back(static_cast<float>(std::sqrt(norm)));
+
+                std::sort(forward.begin(), forward.end());
+                for (const auto& [t, count] : forward) {
+                    index.chunk_terms.push_back(t);
+                    index.chunk_counts.push_back(count);
+                }
+                index.chunk_offsets.push_back(index.chunk_terms.size());
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        // Concatenate the posting lists
+        index.term_offsets.assign(index.terms.size() + 1, 0);
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            index.term_offsets[t + 1] = index.term_offsets[t] + term_postings[t].size();
+        }
+        index.postings.resize(index.term_offsets.back());
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            std::copy(term_postings[t].begin(), term_postings[t].end(), index.postings.begin() + index.term_offsets[t]);
+        }
+        return index;
+    }
+
+    // Save the chunk index to a binary file
+    void save_chunk_index(const ChunkIndex& index, const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open chunk index file: " + path.string());
+        }
+        CODEC::write_value(out, index_magic);
+        CODEC::write_value(out, index_version);
+        CODEC::write_value(out, index.generation);
+        CODEC::write_strings(out, index.title_ids);
+        CODEC::write_strings(out, index.title_names);
+        CODEC::write_vector(out, index.title_starting_ids);
+        CODEC::write_vector(out, index.title_ending_ids);
+        CODEC::write_vector(out, index.chunk_ids);
+        CODEC::write_vector(out, index.chunk_titles);
+        CODEC::write_vector(out, index.chunk_norms);
+        CODEC::write_strings(out, index.terms);
+        CODEC::write_vector(out, index.doc_freqs);
+        CODEC::write_vector(out, index.term_offsets);
+        CODEC::write_vector(out, index.postings);
+        CODEC::write_vector(out, index.chunk_offsets);
+        CODEC::write_vector(out, index.chunk_terms);
+        CODEC::write_vector(out, index.chunk_counts);
+    }
+
+    // Load the chunk index from a binary file written by save_chunk_index
+    ChunkIndex load_chunk_index(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open chunk index file: " + path.string() + ". Run --buildchunkindex first.");
+        }
+        if (CODEC::read_value<uint32_t>(in) != index_magic || CODEC::read_value<uint32_t>(in) != index_version) {
+            throw std::runtime_error("Unsupported chunk index file: " + path.string());
+        }
+        ChunkIndex index;
+        index.generation = CODEC::read_value<int64_t>(in);
+        index.title_ids = CODEC::read_strings(in);
+        index.title_names = CODEC::read_strings(in);
+        index.title_starting_ids = CODEC::read_vector<int64_t>(in);
+        index.title_ending_ids = CODEC::read_vector<int64_t>(in);
+        index.chunk_ids = CODEC::read_vector<int64_t>(in);
+        index.chunk_titles = CODEC::read_vector<int32_t>(in);
+        index.chunk_norms = CODEC::read_vector<float>(in);
+        index.terms = CODEC::read_strings(in);
+        index.doc_freqs = CODEC::read_vector<uint32_t>(in);
+        index.term_offsets = CODEC::read_vector<uint64_t>(in);
+        index.postings = CODEC::read_vector<uint8_t>(in);
+        index.chunk_offsets = CODEC::read_vector<uint64_t>(in);
+        index.chunk_terms = CODEC::read_vector<uint32_t>(in);
+        index.chunk_counts = CODEC::read_vector<uint16_t>(in);
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            index.term_ids.emplace(index.terms[t], static_cast<int>(t));
+        }
+        return index;
+    }
+
+    /**
+     * @brief Score every chunk against the prompt
+     *
+     * Only chunks that contain at least one prompt term are considered, so the accumulator is sparse
+     * in practice even though it is indexed by chunk.
+     *
+     * @return (chunk, score) pairs in descending order of score, ties broken by chunk order
+     */
+    std::vector<std::pair<int, double>> score_prompt(const ChunkIndex& index,
+                                                     const std::map<std::string, int>& tokens,
+                                                     const int& top_n = 100) {
+        std::vector<double> scores(index.num_chunks(), 0.0);
+        std::vector<int> touched;
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = index.find_term(token);
+            if (term < 0) continue;
+            const uint8_t* p = index.postings.data() + index.term_offsets[term];
+            const uint8_t* end = index.postings.data() + index.term_offsets[term + 1];
+            int64_t doc = -1;
+            while (p < end) {
+                uint64_t gap = CODEC::decode_varint(p);
+                uint64_t frequency = CODEC::decode_varint(p);
+                doc = (doc < 0) ? static_cast<int64_t>(gap) - 1 : doc + static_cast<int64_t>(gap);
+                if (scores[doc] == 0.0) touched.push_back(static_cast<int>(doc));
+                scores[doc] += weight * static_cast<double>(frequency) / index.chunk_norms[doc];
+            }
+        }
+
+        std::vector<std::pair<int, double>> result;
+        result.reserve(touched.size());
+        for (int doc : touched) result.push_back({doc, scores[doc]});
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(keep);
+        return result;
+    }
+
+    // Print scored chunks with their chunk id and title
+    void print_results(const ChunkIndex& index, const std::vector<std::pair<int, double>>& results) {
+        std::cout << "Top "<< results.size() <<" Chunk Results:" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        for (const auto& [doc, score] : results) {
+            int32_t title = index.chunk_titles[doc];
+            std::cout << "Chunk ID: " << index.chunk_ids[doc] << std::endl
+            << "Distance: " << score << std::endl
+            << "Name: [[" << ((title >= 0) ? index.title_names[title] : "unknown") << ".pdf]]" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        }
+    }
+
+    // Build the chunk index from the configured database and save it next to it
+    void buildChunkIndex() {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+                sqlite3_close(db);
+                return;
+            }
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            ChunkIndex index;
+            try {
+                index = build_chunk_index(db);
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            save_chunk_index(index, ENV_HPP::chunk_index_path);
+            std::cout << "Indexed " << index.num_chunks() << " chunks, " << index.num_terms() << " terms, "
+                      << index.postings.size() << " posting bytes in " << elapsed.count() << " seconds" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Score buffer.json against the saved chunk index and print the best chunks
+    void processPrompt(const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            ChunkIndex index = load_chunk_index(ENV_HPP::chunk_index_path);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            std::vector<std::pair<int, double>> results = score_prompt(index, tokens, top_n);
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+            print_results(index, results);
+            std::cout << "Scored " << index.num_chunks() << " chunks in " << elapsed.count() << " us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // CHUNK_HPP
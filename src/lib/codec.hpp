@@ -0,0 +1,87 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace CODEC {
+
+    // Append an unsigned integer as a LEB128 varint (7 bits per byte, high bit set on all but the last byte)
+    void encode_varint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Decode one varint at p and advance p past it
+    uint64_t decode_varint(const uint8_t*& p) {
+        uint64_t value = *p & 0x7F;
+        int shift = 7;
+        while (*p++ & 0x80) {
+            value |= static_cast<uint64_t>(*p & 0x7F) << shift;
+            shift += 7;
+        }
+        return value;
+    }
+
+    // Write a trivially copyable value in native byte order
+    template <typename T>
+    void write_value(std::ofstream& out, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T read_value(std::ifstream& in) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("Unexpected end of binary file");
+        }
+        return value;
+    }
+
+    // Write a vector of trivially copyable values, prefixed by its length
+    template <typename T>
+    void write_vector(std::ofstream& out, const std::vector<T>& values) {
+        write_value<uint64_t>(out, values.size());
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    std::vector<T> read_vector(std::ifstream& in) {
+        std::vector<T> values(read_value<uint64_t>(in));
+        if (!in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)))) {
+            throw std::runtime_error("Unexpected end of binary file");
+        }
+        return values;
+    }
+
+    // Write a vector of strings, each prefixed by its length
+    void write_strings(std::ofstream& out, const std::vector<std::string>& values) {
+        write_value<uint64_t>(out, values.size());
+        for (const std::string& value : values) {
+            write_value<uint32_t>(out, static_cast<uint32_t>(value.size()));
+            out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+    }
+
+    std::vector<std::string> read_strings(std::ifstream& in) {
+        std::vector<std::string> values(read_value<uint64_t>(in));
+        for (std::string& value : values) {
+            value.resize(read_value<uint32_t>(in));
+            if (!in.read(value.data(), static_cast<std::streamsize>(value.size()))) {
+                throw std::runtime_error("Unexpected end of binary file");
+            }
+        }
+        return values;
+    }
+}
+
+#endif // CODEC_HPP
@@ -0,0 +1,495 @@
+#ifndef COLUMNAR_HPP
+#define COLUMNAR_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "codec.hpp"
+#include "transform.hpp"
+
+namespace COLUMNAR {
+
+    const uint32_t file_magic = 0x46434153; // "SACF"
+    const uint32_t file_version = 1;
+    // Every buffer starts on this boundary, so a memory-mapped file can be viewed as typed arrays
+    const size_t buffer_alignment = 64;
+    // Rows per compressed block
+    const size_t block_rows = 1 << 16;
+
+    /**
+     * @brief One column of a table, stored contiguously
+     *
+     * Text columns are dictionary encoded: codes holds an int32 index per row into dictionary,
+     * whose entries are kept in order of first appearance.
+     */
+    struct Column {
+        enum class Type { Int64, Float64, Dictionary };
+        std::string name;
+        Type type = Type::Int64;
+        std::vector<int64_t> ints;
+        std::vector<double> floats;
+        std::vector<int32_t> codes;
+        std::vector<std::string> dictionary;
+    };
+
+    struct Table {
+        std::string name;
+        size_t rows = 0;
+        std::vector<Column> columns;
+
+        const Column& column(const std::string& column_name) const {
+            for (const Column& c : columns) {
+                if (c.name == column_name) return c;
+            }
+            throw std::runtime_error("No column " + column_name + " in " + name);
+        }
+    };
+
+    std::string type_name(const Column::Type& type) {
+        switch (type) {
+            case Column::Type::Int64: return "int64";
+            case Column::Type::Float64: return "float64";
+            case Column::Type::Dictionary: return "dictionary";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief Read a whole SQLite table, typing columns by their declared type
+     *
+     * TEXT columns become dictionary columns, INTEGER columns int64 and everything else float64.
+     *
+     * @throws std::runtime_error if the query cannot be prepared.
+     */
+    Table load_table(sqlite3* db, const std::string& table_name) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, ("SELECT * FROM " + table_name + ";").c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("Error preparing statement (" + table_name + "): " + sqlite3_errmsg(db));
+        }
+        Table table;
+        table.name = table_name;
+        std::vector<std::unordered_map<std::string, int32_t>> lookups;
+        for (int i = 0; i < sqlite3_column_count(stmt); ++i) {
+            Column column;
+            column.name = sqlite3_column_name(stmt, i);
+            std::string declared = sqlite3_column_decltype(stmt, i) ? sqlite3_column_decltype(stmt, i) : "";
+            std::transform(declared.begin(), declared.end(), declared.begin(), ::toupper);
+            column.type = (declared.find("TEXT") != std::string::npos) ? Column::Type::Dictionary
+                        : (declared.find("INT") != std::string::npos) ? Column::Type::Int64
+                        : Column::Type::Float64;
+            table.columns.push_back(std::move(column));
+        }
+        lookups.resize(table.columns.size());
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            for (size_t i = 0; i < table.columns.size(); ++i) {
+                Column& column = table.columns[i];
+                switch (column.type) {
+                    case Column::Type::Int64:
+                        column.ints.push_back(sqlite3_column_int64(stmt, static_cast<int>(i)));
+                        break;
+                    case Column::Type::Float64:
+                        column.floats.push_back(sqlite3_column_double(stmt, static_cast<int>(i)));
+                        break;
+                    case Column::Type::Dictionary: {
+                        const unsigned char* text = sqlite3_column_text(stmt, static_cast<int>(i));
+                        std::string value = text ? reinterpret_cast<const char*>(text) : "";
+                        auto [it, inserted] = lookups[i].try_emplace(value, static_cast<int32_t>(column.dictionary.size()));
+                        if (inserted) column.dictionary.push_back(value);
+                        column.codes.push_back(it->second);
+                        break;
+                    }
+                }
+            }
+            ++table.rows;
+        }
+        sqlite3_finalize(stmt);
+        return table;
+    }
+
+    // Zigzag-encoded deltas as varints; sorted or clustered columns shrink to about a byte per row
+    std::vector<uint8_t> compress_block(const int64_t* values, const size_t& count) {
+        std::vector<uint8_t> out;
+        out.reserve(count);
+        int64_t previous = 0;
+        for (size_t i = 0; i < count; ++i) {
+            int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(previous));
+            CODEC::encode_varint(out, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+            previous = values[i];
+        }
+        return out;
+    }
+
+    template <typename T>
+    void decompress_block(const uint8_t* p, const size_t& count, T* values) {
+        int64_t previous = 0;
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t zigzag = CODEC::decode_varint(p);
+            previous += static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+            values[i] = static_cast<T>(previous);
+        }
+    }
+
+    // Appends buffers at aligned offsets and records where they went
+    class BufferWriter {
+    public:
+        explicit BufferWriter(std::ofstream& out) : out(out) {}
+
+        json write(const void* data, const size_t& bytes) {
+            static const char zeros[buffer_alignment] = {};
+            size_t padding = (buffer_alignment - offset % buffer_alignment) % buffer_alignment;
+            out.write(zeros, static_cast<std::streamsize>(padding));
+            offset += padding;
+            json location = {offset, bytes};
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            offset += bytes;
+            return location;
+        }
+
+        size_t position() const { return offset; }
+
+        void advance(const size_t& bytes) { offset += bytes; }
+
+    private:
+        std::ofstream& out;
+        size_t offset = 0;
+    };
+
+    /**
+     * @brief Write a table as one columnar file
+     *
+     * Layout: magic and version, then every column buffer on a 64-byte boundary, then a JSON footer
+     * describing the columns, its length (uint64) and the magic again. Numbers are little-endian.
+     * Uncompressed numeric buffers can be memory-mapped and viewed in place; a dictionary column has
+     * an int32 codes buffer plus the Arrow-style string layout of its dictionary (int32 offsets,
+     * utf8 data). With compress, int64 and code buffers are stored as delta-varint blocks instead.
+     */
+    void write_table(const Table& table, const std::filesystem::path& path, const bool& compress = false) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open columnar file: " + path.string());
+        }
+        BufferWriter writer(out);
+        CODEC::write_value(out, file_magic);
+        CODEC::write_value(out, file_version);
+        writer.advance(2 * sizeof(uint32_t));
+
+        json footer = {{"table", table.name}, {"rows", table.rows}, {"columns", json::array()}};
+        auto write_integers = [&](json& column, const auto& values) {
+            if (!compress) {
+                column["values"] = writer.write(values.data(), values.size() * sizeof(values[0]));
+                return;
+            }
+            column["compression"] = "delta_varint";
+            column["blocks"] = json::array();
+            std::vector<int64_t> widened(values.begin(), values.end());
+            for (size_t begin = 0; begin < widened.size(); begin += block_rows) {
+                size_t count = std::min(block_rows, widened.size() - begin);
+                std::vector<uint8_t> block = compress_block(widened.data() + begin, count);
+                json location = writer.write(block.data(), block.size());
+                location.push_back(count);
+                column["blocks"].push_back(location);
+            }
+        };
+
+        for (const Column& c : table.columns) {
+            json column = {{"name", c.name}, {"type", type_name(c.type)}, {"compression", "none"}};
+            switch (c.type) {
+                case Column::Type::Int64:
+                    write_integers(column, c.ints);
+                    break;
+                case Column::Type::Float64:
+                    column["values"] = writer.write(c.floats.data(), c.floats.size() * sizeof(double));
+                    break;
+                case Column::Type::Dictionary: {
+                    write_integers(column, c.codes);
+                    std::vector<int32_t> offsets = {0};
+                    std::string data;
+                    for (const std::string& value : c.dictionary) {
+                        data += value;
+                        offsets.push_back(static_cast<int32_t>(data.size()));
+                    }
+                    column["dictionary_size"] = c.dictionary.size();
+                    column["dictionary_offsets"] = writer.write(offsets.data(), offsets.size() * sizeof(int32_t));
+                    column["dictionary_data"] = writer.write(data.data(), data.size());
+                    break;
+                }
+            }
+            footer["columns"].push_back(column);
+        }
+
+        std::string text = footer.dump();
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        CODEC::write_value<uint64_t>(out, text.size());
+        CODEC::write_value(out, file_magic);
+    }
+
+    /**
+     * @brief Read a columnar file written by write_table
+     *
+     * The file is read with a single read; uncompressed columns are then copied out in one memcpy each.
+     *
+     * @throws std::runtime_error if the file is missing, truncated or not a columnar file.
+     */
+    Table read_table(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open columnar file: " + path.string());
+        }
+        std::vector<char> bytes(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        const size_t trailer = sizeof(uint64_t) + sizeof(uint32_t);
+        uint32_t magic = 0, version = 0, end_magic = 0;
+        uint64_t footer_size = 0;
+        if (bytes.size() < 2 * sizeof(uint32_t) + trailer) throw std::runtime_error("Truncated columnar file: " + path.string());
+        std::memcpy(&magic, bytes.data(), sizeof(uint32_t));
+        std::memcpy(&version, bytes.data() + sizeof(uint32_t), sizeof(uint32_t));
+        std::memcpy(&footer_size, bytes.data() + bytes.size() - trailer, sizeof(uint64_t));
+        std::memcpy(&end_magic, bytes.data() + bytes.size() - sizeof(uint32_t), sizeof(uint32_t));
+        if (magic != file_magic || end_magic != file_magic || version != file_version || footer_size > bytes.size() - trailer) {
+            throw std::runtime_error("Not a columnar file of version " + std::to_string(file_version) + ": " + path.string());
+        }
+        json footer = json::parse(bytes.begin() + static_cast<ptrdiff_t>(bytes.size() - trailer - footer_size), bytes.end() - trailer);
+
+        auto buffer = [&](const json& location) {
+            size_t offset = location[0].get<size_t>(), size = location[1].get<size_t>();
+            if (offset + size > bytes.size()) throw std::runtime_error("Corrupt columnar file: " + path.string());
+            return std::make_pair(bytes.data() + offset, size);
+        };
+        auto read_integers = [&](const json& column, auto& values, const size_t& rows) {
+            values.resize(rows);
+            if (column["compression"] == "none") {
+                auto [data, size] = buffer(column["values"]);
+                std::memcpy(values.data(), data, std::min(size, rows * sizeof(values[0])));
+                return;
+            }
+            size_t row = 0;
+            for (const json& block : column["blocks"]) {
+                size_t count = block[2].get<size_t>();
+                if (row + count > rows) throw std::runtime_error("Corrupt columnar file: " + path.string());
+                decompress_block(reinterpret_cast<const uint8_t*>(buffer(block).first), count, values.data() + row);
+                row += count;
+            }
+        };
+
+        Table table;
+        table.name = footer["table"].get<std::string>();
+        table.rows = footer["rows"].get<size_t>();
+        for (const json& column : footer["columns"]) {
+            Column c;
+            c.name = column["name"].get<std::string>();
+            std::string type = column["type"].get<std::string>();
+            if (type == "int64") {
+                c.type = Column::Type::Int64;
+                read_integers(column, c.ints, table.rows);
+            } else if (type == "float64") {
+                c.type = Column::Type::Float64;
+                c.floats.resize(table.rows);
+                auto [data, size] = buffer(column["values"]);
+                std::memcpy(c.floats.data(), data, std::min(size, table.rows * sizeof(double)));
+            } else {
+                c.type = Column::Type::Dictionary;
+                read_integers(column, c.codes, table.rows);
+                size_t dictionary_size = column["dictionary_size"].get<size_t>();
+                std::vector<int32_t> offsets(dictionary_size + 1);
+                auto [offset_data, offset_size] = buffer(column["dictionary_offsets"]);
+                std::memcpy(offsets.data(), offset_data, std::min(offset_size, offsets.size() * sizeof(int32_t)));
+                const char* data = buffer(column["dictionary_data"]).first;
+                c.dictionary.reserve(dictionary_size);
+                for (size_t i = 0; i < dictionary_size; ++i) c.dictionary.emplace_back(data + offsets[i], data + offsets[i + 1]);
+            }
+            table.columns.push_back(std::move(c));
+        }
+        return table;
+    }
+
+    // Path of the columnar export of a table
+    std::filesystem::path export_path(const std::string& table_name) {
+        return ENV_HPP::processed_data_path / (table_name + ".col");
+    }
+
+    // Export file_token and relation_distance, the data of data_dumper.csv and token_filter.csv
+    void exportColumnar(const bool& compress = false) {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                throw std::runtime_error(message);
+            }
+            std::vector<Table> tables;
+            try {
+                tables.push_back(load_table(db, "file_token"));
+                tables.push_back(load_table(db, "relation_distance"));
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+
+            std::filesystem::create_directories(ENV_HPP::processed_data_path);
+            for (const Table& table : tables) {
+                std::filesystem::path path = export_path(table.name);
+                write_table(table, path, compress);
+                std::cout << "Exported " << table.rows << " rows of " << table.name << " to " << path
+                          << " (" << std::filesystem::file_size(path) << " bytes)" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Write a table as CSV the way the dump functions do, for comparison
+    void write_csv(const Table& table, const std::filesystem::path& path) {
+        std::ofstream out(path);
+        for (size_t c = 0; c < table.columns.size(); ++c) out << (c ? ", " : "") << table.columns[c].name;
+        out << "\n";
+        for (size_t row = 0; row < table.rows; ++row) {
+            for (size_t c = 0; c < table.columns.size(); ++c) {
+                const Column& column = table.columns[c];
+                if (c) out << ", ";
+                switch (column.type) {
+                    case Column::Type::Int64: out << column.ints[row]; break;
+                    case Column::Type::Float64: out << column.floats[row]; break;
+                    case Column::Type::Dictionary: out << column.dictionary[column.codes[row]]; break;
+                }
+            }
+            out << "\n";
+        }
+    }
+
+    // Parse such a CSV back into columns the way a notebook would
+    size_t read_csv(const std::filesystem::path& path, Table& table) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        std::vector<std::unordered_map<std::string, int32_t>> lookups(table.columns.size());
+        size_t rows = 0;
+        while (std::getline(in, line)) {
+            size_t start = 0;
+            for (size_t c = 0; c < table.columns.size(); ++c) {
+                size_t end = line.find(", ", start);
+                std::string field = line.substr(start, end - start);
+                Column& column = table.columns[c];
+                switch (column.type) {
+                    case Column::Type::Int64: column.ints.push_back(std::stoll(field)); break;
+                    case Column::Type::Float64: column.floats.push_back(std::stod(field)); break;
+                    case Column::Type::Dictionary: {
+                        auto [it, inserted] = lookups[c].try_emplace(field, static_cast<int32_t>(column.dictionary.size()));
+                        if (inserted) column.dictionary.push_back(field);
+                        column.codes.push_back(it->second);
+                        break;
+                    }
+                }
+                start = (end == std::string::npos) ? line.size() : end + 2;
+            }
+            ++rows;
+        }
+        return rows;
+    }
+
+    /**
+     * @brief Compare export and load times of the columnar format and CSV on relation_distance
+     *
+     * The relation_distance table can be replicated to give the benchmark a larger input.
+     */
+    void benchmarkExport(const size_t& replicas = 1) {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                throw std::runtime_error(message);
+            }
+            Table table;
+            try {
+                table = load_table(db, "relation_distance");
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+
+            // Each replica gets its own file names, so dictionaries grow as they would with more titles
+            const size_t original_rows = table.rows;
+            // Append by index after reserving; inserting a vector's own range into itself is undefined
+            auto replicate = [&](auto& values) {
+                values.reserve(original_rows * replicas);
+                for (size_t r = 1; r < replicas; ++r) {
+                    for (size_t row = 0; row < original_rows; ++row) values.push_back(values[row]);
+                }
+            };
+            for (Column& column : table.columns) {
+                if (column.type == Column::Type::Int64) replicate(column.ints);
+                if (column.type == Column::Type::Float64) replicate(column.floats);
+                if (column.type != Column::Type::Dictionary) continue;
+                const bool per_title = (column.name == "file_name");
+                const int32_t original_size = static_cast<int32_t>(column.dictionary.size());
+                column.codes.reserve(original_rows * replicas);
+                if (per_title) column.dictionary.reserve(column.dictionary.size() * replicas);
+                for (size_t r = 1; r < replicas; ++r) {
+                    for (size_t row = 0; row < original_rows; ++row) {
+                        column.codes.push_back(per_title ? column.codes[row] + static_cast<int32_t>(r) * original_size : column.codes[row]);
+                    }
+                    if (per_title) {
+                        for (int32_t i = 0; i < original_size; ++i) column.dictionary.push_back(column.dictionary[i] + "_" + std::to_string(r));
+                    }
+                }
+            }
+            table.rows = original_rows * replicas;
+
+            std::filesystem::create_directories(ENV_HPP::processed_data_path);
+            const std::filesystem::path csv_path = ENV_HPP::processed_data_path / "benchmark_export.csv";
+            const std::filesystem::path col_path = ENV_HPP::processed_data_path / "benchmark_export.col";
+            const std::filesystem::path packed_path = ENV_HPP::processed_data_path / "benchmark_export_packed.col";
+            auto time_ms = [](const auto& fn) {
+                std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                fn();
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            double csv_write = time_ms([&]() { write_csv(table, csv_path); });
+            double col_write = time_ms([&]() { write_table(table, col_path, false); });
+            double packed_write = time_ms([&]() { write_table(table, packed_path, true); });
+            Table csv_table = table, col_table, packed_table;
+            for (Column& column : csv_table.columns) {
+                column.ints.clear();
+                column.floats.clear();
+                column.codes.clear();
+                column.dictionary.clear();
+            }
+            double csv_read = time_ms([&]() { read_csv(csv_path, csv_table); });
+            double col_read = time_ms([&]() { col_table = read_table(col_path); });
+            double packed_read = time_ms([&]() { packed_table = read_table(packed_path); });
+            const bool same = col_table.column("frequency").ints == table.column("frequency").ints
+                           && packed_table.column("Token").codes == table.column("Token").codes
+                           && packed_table.column("file_name").dictionary == table.column("file_name").dictionary;
+
+            std::cout << table.rows << " rows of relation_distance" << std::endl
+                      << "CSV:        " << std::filesystem::file_size(csv_path) << " bytes, write " << csv_write << " ms, read " << csv_read << " ms" << std::endl
+                      << "Columnar:   " << std::filesystem::file_size(col_path) << " bytes, write " << col_write << " ms, read " << col_read << " ms" << std::endl
+                      << "Compressed: " << std::filesystem::file_size(packed_path) << " bytes, write " << packed_write << " ms, read " << packed_read << " ms" << std::endl
+                      << "Round trip " << (same ? "matches" : "DIFFERS") << std::endl;
+            std::filesystem::remove(csv_path);
+            std::filesystem::remove(col_path);
+            std::filesystem::remove(packed_path);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // COLUMNAR_HPP
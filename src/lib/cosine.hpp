@@ -0,0 +1,274 @@
+#ifndef COSINE_HPP
+#define COSINE_HPP
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <unordered_set>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "index.hpp"
+#include "sparse.hpp"
+#include "parallel.hpp"
+
+namespace COSINE {
+
+    // Storage type of the normalized document weights
+    enum class Precision { Float64, Float32, Int8 };
+
+    const char* precision_name(const Precision& precision) {
+        switch (precision) {
+            case Precision::Float64: return "float64";
+            case Precision::Float32: return "float32";
+            case Precision::Int8: return "int8";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief L2-normalized document vectors stored at a chosen precision
+     *
+     * The sparsity structure is shared with the CSR matrix; only the value array of the chosen
+     * precision is filled. Int8 rows are calibrated with one scale per row so that the largest
+     * weight of every row maps to 127.
+     */
+    struct CosineMatrix {
+        Precision precision = Precision::Float64;
+        SPARSE::CSRMatrix matrix;            // values are filled for Float64 only
+        std::vector<float> values_f32;
+        std::vector<int8_t> values_i8;
+        std::vector<float> row_scales;       // Int8 only: weight = value * row_scale
+
+        // Bytes of weights and column indices streamed by one full scoring pass
+        size_t bytes_per_query() const {
+            size_t value_bytes = (precision == Precision::Float64) ? sizeof(double)
+                               : (precision == Precision::Float32) ? sizeof(float) : sizeof(int8_t);
+            return matrix.nnz() * (value_bytes + sizeof(int32_t)) + row_scales.size() * sizeof(float);
+        }
+    };
+
+    /**
+     * @brief Normalize every row of the CSR matrix to unit length and store it at the given precision
+     *
+     * @param source The document-term matrix built from relation_distance
+     * @param precision The storage type of the normalized weights
+     * @return The normalized matrix
+     */
+    CosineMatrix build_cosine_matrix(const SPARSE::CSRMatrix& source, const Precision& precision) {
+        CosineMatrix result;
+        result.precision = precision;
+        result.matrix.rows = source.rows;
+        result.matrix.cols = source.cols;
+        result.matrix.row_offsets = source.row_offsets;
+        result.matrix.col_indices = source.col_indices;
+
+        std::vector<double> normalized(source.nnz());
+        for (size_t r = 0; r < source.rows; ++r) {
+            double norm = 0.0;
+            for (uint32_t i = source.row_offsets[r]; i < source.row_offsets[r + 1]; ++i) {
+                norm += source.values[i] * source.values[i];
+            }
+            norm = std::sqrt(norm);
+            for (uint32_t i = source.row_offsets[r]; i < source.row_offsets[r + 1]; ++i) {
+                normalized[i] = (norm > 0.0) ? source.values[i] / norm : 0.0;
+            }
+        }
+
+        if (precision == Precision::Float64) {
+            result.matrix.values = std::move(normalized);
+        } else if (precision == Precision::Float32) {
+            result.values_f32.assign(normalized.begin(), normalized.end());
+        } else {
+            result.values_i8.resize(normalized.size());
+            result.row_scales.resize(source.rows);
+            for (size_t r = 0; r < source.rows; ++r) {
+                double max_abs = 0.0;
+                for (uint32_t i = source.row_offsets[r]; i < source.row_offsets[r + 1]; ++i) {
+                    max_abs = std::max(max_abs, std::abs(normalized[i]));
+                }
+                double scale = (max_abs > 0.0) ? max_abs / 127.0 : 1.0;
+                result.row_scales[r] = static_cast<float>(scale);
+                for (uint32_t i = source.row_offsets[r]; i < source.row_offsets[r + 1]; ++i) {
+                    result.values_i8[i] = static_cast<int8_t>(std::lround(normalized[i] / scale));
+                }
+            }
+        }
+        return result;
+    }
+
+    // Build the unit-length dense prompt vector over the index vocabulary
+    std::vector<double> normalized_prompt_vector(const INDEX::TitleIndex& index, const std::map<std::string, int>& tokens) {
+        std::vector<double> x = SPARSE::dense_prompt_vector(index, tokens);
+        double norm = 0.0;
+        for (double value : x) norm += value * value;
+        norm = std::sqrt(norm);
+        if (norm > 0.0) {
+            for (double& value : x) value /= norm;
+        }
+        return x;
+    }
+
+    // Float32 rows against a float32 prompt, eight lanes at a time when AVX2 is available
+    void multiply_f32(const CosineMatrix& cosine, const float* x, double* y, size_t row_begin, size_t row_end) {
+        const uint32_t* offsets = cosine.matrix.row_offsets.data();
+        const int32_t* cols = cosine.matrix.col_indices.data();
+        const float* values = cosine.values_f32.data();
+        for (size_t r = row_begin; r < row_end; ++r) {
+            uint32_t i = offsets[r];
+            const uint32_t end = offsets[r + 1];
+            float sum = 0.0f;
+#if defined(__AVX2__) && defined(__FMA__)
+            __m256 acc = _mm256_setzero_ps();
+            for (; i + 8 <= end; i += 8) {
+                __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols + i));
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), _mm256_i32gather_ps(x, idx, 4), acc);
+            }
+            __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+            half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+            sum = _mm_cvtss_f32(_mm_add_ss(half, _mm_movehdup_ps(half)));
+#endif
+            for (; i < end; ++i) {
+                sum += values[i] * x[cols[i]];
+            }
+            y[r] = sum;
+        }
+    }
+
+    // Int8 rows against an int8-calibrated prompt (held as int32 for gathering), accumulated in int32
+    void multiply_i8(const CosineMatrix& cosine, const int32_t* x, const float& x_scale, double* y, size_t row_begin, size_t row_end) {
+        const uint32_t* offsets = cosine.matrix.row_offsets.data();
+        const int32_t* cols = cosine.matrix.col_indices.data();
+        const int8_t* values = cosine.values_i8.data();
+        for (size_t r = row_begin; r < row_end; ++r) {
+            uint32_t i = offsets[r];
+            const uint32_t end = offsets[r + 1];
+            int32_t sum = 0;
+#if defined(__AVX2__)
+            __m256i acc = _mm256_setzero_si256();
+            for (; i + 8 <= end; i += 8) {
+                __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols + i));
+                __m256i w = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values + i)));
+                acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(w, _mm256_i32gather_epi32(x, idx, 4)));
+            }
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+            sum = _mm_cvtsi128_si32(half);
+#endif
+            for (; i < end; ++i) {
+                sum += static_cast<int32_t>(values[i]) * x[cols[i]];
+            }
+            y[r] = static_cast<double>(sum) * cosine.row_scales[r] * x_scale;
+        }
+    }
+
+    /**
+     * @brief Compute the cosine similarity between the prompt and every title
+     *
+     * @param cosine The normalized document matrix
+     * @param x The unit-length dense prompt vector
+     * @param num_threads The number of threads to use
+     * @return One cosine similarity per document
+     */
+    std::vector<double> score(const CosineMatrix& cosine, const std::vector<double>& x,
+                              const unsigned int& num_threads = PARALLEL::default_threads()) {
+        if (cosine.precision == Precision::Float64) {
+            return SPARSE::multiply(cosine.matrix, x, num_threads);
+        }
+
+        std::vector<double> y(cosine.matrix.rows, 0.0);
+        if (cosine.matrix.rows == 0) return y;
+
+        std::vector<float> x_f32;
+        std::vector<int32_t> x_i8;
+        float x_scale = 1.0f;
+        if (cosine.precision == Precision::Float32) {
+            x_f32.assign(x.begin(), x.end());
+        } else {
+            double max_abs = 0.0;
+            for (double value : x) max_abs = std::max(max_abs, std::abs(value));
+            x_scale = static_cast<float>((max_abs > 0.0) ? max_abs / 127.0 : 1.0);
+            x_i8.resize(x.size());
+            for (size_t i = 0; i < x.size(); ++i) {
+                x_i8[i] = static_cast<int32_t>(std::lround(x[i] / x_scale));
+            }
+        }
+
+        std::vector<size_t> bounds = SPARSE::partition_rows(cosine.matrix, num_threads);
+        PARALLEL::parallel_for(bounds.size() - 1, [&](size_t begin, size_t end, unsigned int) {
+            for (size_t p = begin; p < end; ++p) {
+                if (cosine.precision == Precision::Float32) {
+                    multiply_f32(cosine, x_f32.data(), y.data(), bounds[p], bounds[p + 1]);
+                } else {
+                    multiply_i8(cosine, x_i8.data(), x_scale, y.data(), bounds[p], bounds[p + 1]);
+                }
+            }
+        }, static_cast<unsigned int>(bounds.size() - 1));
+        return y;
+    }
+
+    // Fraction of the reference top results that also appear in the candidate top results
+    double overlap_at_k(const std::vector<std::pair<int, double>>& reference, const std::vector<std::pair<int, double>>& candidate) {
+        if (reference.empty()) return 1.0;
+        std::unordered_set<int> docs;
+        for (const auto& [doc, score] : candidate) docs.insert(doc);
+        size_t shared = 0;
+        for (const auto& [doc, score] : reference) shared += docs.count(doc);
+        return static_cast<double>(shared) / reference.size();
+    }
+
+    /**
+     * @brief Process buffer.json with cosine scoring at the given precision
+     *
+     * Prints, for every precision, the bytes streamed per query, the scoring time, the largest score
+     * error and the top_n overlap with the float64 ranking, so the precision can be picked from the
+     * deviation it causes; then prints the top results of the chosen precision.
+     */
+    void processPrompt(const Precision& precision, const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            INDEX::TitleIndex index = INDEX::load_title_index();
+            SPARSE::CSRMatrix source = SPARSE::build_csr(index);
+            std::vector<double> x = normalized_prompt_vector(index, tokens);
+
+            std::vector<double> reference_scores = score(build_cosine_matrix(source, Precision::Float64), x);
+            std::vector<std::pair<int, double>> reference = INDEX::top_k(reference_scores, top_n);
+
+            std::vector<std::pair<int, double>> chosen;
+            std::cout << "Ranking deviation against float64 cosine scores (top " << top_n << "):" << std::endl;
+            for (Precision candidate : {Precision::Float64, Precision::Float32, Precision::Int8}) {
+                CosineMatrix cosine = build_cosine_matrix(source, candidate);
+                std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                std::vector<double> scores = score(cosine, x);
+                std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+                double max_error = 0.0;
+                for (size_t doc = 0; doc < scores.size(); ++doc) {
+                    max_error = std::max(max_error, std::abs(scores[doc] - reference_scores[doc]));
+                }
+                std::cout << "  " << precision_name(candidate)
+                          << ": " << cosine.bytes_per_query() << " bytes/query"
+                          << ", score " << elapsed.count() << " us"
+                          << ", max error " << max_error
+                          << ", overlap " << overlap_at_k(reference, INDEX::top_k(scores, top_n)) << std::endl;
+
+                if (candidate == precision) chosen = INDEX::top_k(scores, top_n);
+            }
+
+            std::cout << "Scored with " << precision_name(precision) << " weights" << std::endl;
+            INDEX::print_results(index, chosen);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // COSINE_HPP
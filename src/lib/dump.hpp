@@ -0,0 +1,240 @@
+#ifndef DUMP_HPP
+#define DUMP_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+#include "env.hpp"
+#include "utilities.hpp"
+
+namespace DUMP {
+
+    // Bytes collected per file before a block is handed to the writer thread
+    const size_t block_bytes = 64 << 10;
+    // Stream buffer of every open dump file
+    const size_t stream_buffer_bytes = 1 << 20;
+
+    /**
+     * @brief Bounded lock-free queue for exactly one producer and one consumer thread
+     *
+     * head is only written by the consumer and tail only by the producer; each side reads the
+     * other's index with acquire ordering, so a slot is never read before it is fully written.
+     */
+    template <typename T, size_t Capacity>
+    class SpscQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        bool try_push(T& value) {
+            const size_t tail_index = tail.load(std::memory_order_relaxed);
+            if (tail_index - head.load(std::memory_order_acquire) == Capacity) return false;
+            slots[tail_index & (Capacity - 1)] = std::move(value);
+            tail.store(tail_index + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& value) {
+            const size_t head_index = head.load(std::memory_order_relaxed);
+            if (head_index == tail.load(std::memory_order_acquire)) return false;
+            value = std::move(slots[head_index & (Capacity - 1)]);
+            head.store(head_index + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<T, Capacity> slots;
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    };
+
+    // Formatted text destined for one of the writer's files
+    struct Block {
+        size_t file = 0;
+        std::string text;
+    };
+
+    /**
+     * @brief Append-only writer that keeps its files open and writes them from a background thread
+     *
+     * The producing thread formats into one pending string per file and hands over a block every
+     * block_bytes through a SpscQueue; the writer thread sleeps on an atomic counter while the queue
+     * is empty. Only one thread may call append(). close() (or the destructor) hands over what is
+     * pending, waits for the writer thread and flushes the files.
+     */
+    class AsyncWriter {
+    public:
+        explicit AsyncWriter(const std::vector<std::filesystem::path>& paths, const std::ios::openmode& mode = std::ios::app)
+            : pending(paths.size()) {
+            for (const std::filesystem::path& path : paths) {
+                buffers.push_back(std::make_unique<char[]>(stream_buffer_bytes));
+                files.push_back(std::make_unique<std::ofstream>());
+                files.back()->rdbuf()->pubsetbuf(buffers.back().get(), stream_buffer_bytes);
+                files.back()->open(path, mode | std::ios::app);
+                if (!files.back()->is_open()) {
+                    std::cout << "Could not open dump file: " << path << std::endl;
+                }
+            }
+            for (std::string& text : pending) text.reserve(block_bytes + 4096);
+            writer = std::thread([this]() { run(); });
+        }
+
+        ~AsyncWriter() { close(); }
+
+        AsyncWriter(const AsyncWriter&) = delete;
+        AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+        // The pending text of a file, to format into directly; call commit(file) afterwards
+        std::string& buffer(const size_t& file) { return pending[file]; }
+
+        void commit(const size_t& file) {
+            if (pending[file].size() >= block_bytes) submit(file);
+        }
+
+        void append(const size_t& file, std::string_view text) {
+            pending[file].append(text);
+            commit(file);
+        }
+
+        void close() {
+            if (!writer.joinable()) return;
+            for (size_t file = 0; file < pending.size(); ++file) {
+                if (!pending[file].empty()) submit(file);
+            }
+            stopping.store(true, std::memory_order_release);
+            signal();
+            writer.join();
+            for (std::unique_ptr<std::ofstream>& file : files) file->flush();
+        }
+
+    private:
+        void submit(const size_t& file) {
+            Block block = {.file = file, .text = std::move(pending[file])};
+            // The writer thread is far faster than formatting, so a full queue only ever waits briefly
+            while (!queue.try_push(block)) std::this_thread::yield();
+            signal();
+            pending[file] = std::string();
+            pending[file].reserve(block_bytes + 4096);
+        }
+
+        void signal() {
+            published.fetch_add(1, std::memory_order_release);
+            published.notify_one();
+        }
+
+        void run() {
+            Block block;
+            uint64_t seen = published.load(std::memory_order_acquire);
+            while (true) {
+                while (queue.try_pop(block)) {
+                    if (files[block.file]->is_open()) files[block.file]->write(block.text.data(), static_cast<std::streamsize>(block.text.size()));
+                }
+                if (stopping.load(std::memory_order_acquire)) {
+                    // Blocks submitted before stopping was set are visible now
+                    while (queue.try_pop(block)) {
+                        if (files[block.file]->is_open()) files[block.file]->write(block.text.data(), static_cast<std::streamsize>(block.text.size()));
+                    }
+                    return;
+                }
+                published.wait(seen, std::memory_order_acquire);
+                seen = published.load(std::memory_order_acquire);
+            }
+        }
+
+        std::vector<std::unique_ptr<char[]>> buffers;
+        std::vector<std::unique_ptr<std::ofstream>> files;
+        std::vector<std::string> pending;
+        SpscQueue<Block, 64> queue;
+        std::atomic<uint64_t> published{0};
+        std::atomic<bool> stopping{false};
+        std::thread writer;
+    };
+
+    // Append an integer with std::to_chars
+    template <typename Integer>
+    void append_number(std::string& out, const Integer& value) {
+        char digits[24];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // Append a double with 6 significant digits, the text std::ostream writes by default
+    void append_number(std::string& out, const double& value) {
+        char digits[32];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+        out.append(digits, result.ptr);
+    }
+
+    /**
+     * @brief The data_dumper and token_filter CSV dumps of computeRelationalDistance
+     *
+     * data_dumper gets "path, sum, unique tokens, relational distance" per title and token_filter
+     * "path, token, count, weight" per filtered token, numbers formatted as std::ostream does.
+     */
+    class EntryDumper {
+    public:
+        EntryDumper() : writer({ENV_HPP::data_dumper_path, ENV_HPP::filtered_data_path}) {}
+
+        void dump(const DataEntry& entry) {
+            std::string& main_text = writer.buffer(0);
+            main_text.append(entry.path).append(", ");
+            append_number(main_text, entry.sum);
+            main_text.append(", ");
+            append_number(main_text, entry.num_unique_tokens);
+            main_text.append(", ");
+            append_number(main_text, entry.relational_distance);
+            main_text.push_back('\n');
+            writer.commit(0);
+
+            std::string& filtered_text = writer.buffer(1);
+            for (const std::tuple<std::string, int, double>& token : entry.filtered_tokens) {
+                filtered_text.append(entry.path).append(", ").append(std::get<0>(token)).append(", ");
+                append_number(filtered_text, std::get<1>(token));
+                filtered_text.append(", ");
+                append_number(filtered_text, std::get<2>(token));
+                filtered_text.push_back('\n');
+            }
+            writer.commit(1);
+        }
+
+        void close() { writer.close(); }
+
+    private:
+        AsyncWriter writer;
+    };
+
+    // The data_info CSV dump of computeResourceData, one line per file in the column order of reset_file_info_dumper
+    class InfoDumper {
+    public:
+        InfoDumper() : writer({ENV_HPP::data_info_path}, std::ios::binary) {}
+
+        void dump(const DataInfo& info) {
+            std::string& text = writer.buffer(0);
+            text.append(info.id).append(", ").append(info.file_name).append(", ").append(info.file_path).append(", ");
+            append_number(text, info.epoch_time);
+            text.append(", ");
+            append_number(text, info.chunk_count);
+            text.append(", ");
+            append_number(text, info.starting_id);
+            text.append(", ");
+            append_number(text, info.ending_id);
+            text.push_back('\n');
+            writer.commit(0);
+        }
+
+        void close() { writer.close(); }
+
+    private:
+        AsyncWriter writer;
+    };
+}
+
+#endif // DUMP_HPP
@@ -2,6 +2,9 @@
 #define ENV_HPP
 
 #include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
 
 namespace ENV_HPP {
     // source paths
@@ -10,19 +13,78 @@ namespace ENV_HPP {
     // get the main.cpp working directory, then go up one level, go onw level down to data folder
     std::filesystem::path data_root = std::filesystem::current_path() / ("data");
 
-    std::filesystem::path json_path = data_root / ("token_json");
-    std::filesystem::path database_path = data_root / ("pdf_text.db");
-    std::filesystem::path output_path = data_root / ("processed_data");
-    std::filesystem::path logging_path = data_root / ("progress.log");
-    std::filesystem::path processed_data_path = data_root / ("processed_data");
-    std::filesystem::path data_dumper_path = processed_data_path / ("data_dumper.csv");
-    std::filesystem::path filtered_data_path = processed_data_path / ("token_filter.csv");
-    std::filesystem::path data_info_path = processed_data_path / ("data_info.csv");
-    std::filesystem::path buffer_json_path = data_root / ("buffer.json");
-    std::filesystem::path global_terms_path = data_root / ("global_word_freq.json");
+    std::filesystem::path json_path;
+    std::filesystem::path database_path;
+    std::filesystem::path output_path;
+    std::filesystem::path logging_path;
+    std::filesystem::path processed_data_path;
+    std::filesystem::path data_dumper_path;
+    std::filesystem::path filtered_data_path;
+    std::filesystem::path data_info_path;
+    std::filesystem::path buffer_json_path;
+    std::filesystem::path socket_path;
+    std::filesystem::path batch_prompt_path;
+    std::filesystem::path batch_result_path;
+    std::filesystem::path chunk_index_path;
+    std::filesystem::path positional_index_path;
+    std::filesystem::path impact_index_path;
+    std::filesystem::path vocab_trie_path;
+    std::filesystem::path phrase_query_path;
+    std::filesystem::path metrics_report_path;
+
+    // Derive every data path from data_root
+    void derive_data_paths() {
+        json_path = data_root / ("token_json");
+        database_path = data_root / ("pdf_text.db");
+        output_path = data_root / ("processed_data");
+        logging_path = data_root / ("progress.log");
+        processed_data_path = data_root / ("processed_data");
+        data_dumper_path = processed_data_path / ("data_dumper.csv");
+        filtered_data_path = processed_data_path / ("token_filter.csv");
+        data_info_path = processed_data_path / ("data_info.csv");
+        buffer_json_path = data_root / ("buffer.json");
+        socket_path = data_root / ("query.sock");
+        batch_prompt_path = data_root / ("batch_prompts.jsonl");
+        batch_result_path = processed_data_path / ("batch_results.jsonl");
+        chunk_index_path = data_root / ("chunk_index.bin");
+        positional_index_path = data_root / ("positional_index.bin");
+        impact_index_path = data_root / ("impact_index.bin");
+        vocab_trie_path = data_root / ("vocab_trie.bin");
+        phrase_query_path = data_root / ("phrase_queries.txt");
+        metrics_report_path = processed_data_path / ("metrics.json");
+    }
+
+    // The paths above are derived from the default data_root before main runs
+    const bool data_paths_derived = (derive_data_paths(), true);
+
+    // Point every data path at another data root, e.g. a synthetic corpus; resource_path is left alone
+    [[maybe_unused]] void use_data_root(const std::filesystem::path& root) {
+        data_root = root;
+        derive_data_paths();
+    }
 
     const int max_length = 14;
     const int min_value = 3;
+    const int default_top_n = 100;
+    const size_t result_cache_capacity = 4096;
+    const size_t max_request_bytes = 1 << 20;
+    const int candidate_depth = 50;
+    // Levenshtein radius for unknown prompt tokens; on a 100k-term vocabulary a lookup takes ~10 us at
+    // distance 1 and ~300 us at distance 2, paid only by tokens with no term within distance 1
+    const int fuzzy_distance = 1;
+    const size_t max_expansions = 3;
+    const size_t sketch_memory_budget = 64 << 20;
+    const bool columnar_compression = false;
+    const size_t export_benchmark_replicas = 200;
+    const std::string shm_ring_name = "/study_ingest";
+    const uint64_t shm_ring_bytes = 16 << 20;
+    const uint32_t shm_ring_producers = 1;
+    const size_t ring_benchmark_titles = 20000;
+    const size_t synthetic_titles = 1000;
+    const size_t synthetic_vocabulary = 50000;
+    const double synthetic_skew = 1.0;
+    const size_t synthetic_tokens_per_title = 1000;
+    const std::vector<size_t> scaling_benchmark_scales = {1000, 2000, 4000};
 }
 
 #endif // ENV_HPP
@@ -5,13 +5,22 @@
 #include <vector>
 #include <map>
 #include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
 #include <memory> // For smart pointers
+#include <optional>
+#include <string_view>
 #include <sqlite3.h>
 
 #include "utilities.hpp"
 #include "env.hpp"
 #include "transform.hpp"
 #include "updateDB.hpp"
+#include "parallel.hpp"
+#include "sketch.hpp"
+#include "dump.hpp"
+#include "metrics.hpp"
 
 namespace FEATURE {
     
@@ -33,6 +42,337 @@ namespace FEATURE {
         }
     }
 
+    // Corpus-wide statistics of one term
+    struct TermStats {
+        int64_t count = 0;               // Occurrences over all titles
+        int64_t document_frequency = 0;  // Titles containing the term; 0 when unknown
+    };
+
+    // Summary counters of a global_terms build, printed instead of one line per term
+    struct GlobalTermsSummary {
+        size_t files = 0;
+        int64_t tokens = 0;
+        size_t distinct_terms = 0;
+        size_t inserted = 0;
+        size_t filtered = 0;
+    };
+
+    /**
+     * @brief Count every term over the token files with a map-reduce over worker threads
+     *
+     * Each worker parses a contiguous range of files into its own tables, one per shard of the term
+     * hash, so no counter is shared during the map phase. Shard s of every worker is then merged by
+     * one worker, which keeps the reduce phase parallel without locks.
+     *
+     * @return (term, stats) pairs sorted by term
+     */
+    std::vector<std::pair<std::string, TermStats>> compute_global_terms(const std::vector<std::filesystem::path>& files,
+                                                                        GlobalTermsSummary& summary,
+                                                                        unsigned int num_threads = PARALLEL::default_threads()) {
+        num_threads = static_cast<unsigned int>(std::clamp<size_t>(num_threads, 1, std::max<size_t>(1, files.size())));
+        const size_t num_shards = num_threads;
+        std::hash<std::string> hash;
+
+        // partials[worker][shard]
+        std::vector<std::vector<std::unordered_map<std::string, TermStats>>> partials(num_threads, std::vector<std::unordered_map<std::string, TermStats>>(num_shards));
+        std::vector<int64_t> worker_tokens(num_threads, 0);
+        PARALLEL::parallel_for(files.size(), [&](size_t begin, size_t end, unsigned int worker) {
+            METRICS::ScopedTimer map_timer("global_terms.map");
+            for (size_t f = begin; f < end; ++f) {
+                for (const auto& [term, count] : TRANSFORMER::json_to_map(files[f])) {
+                    TermStats& stats = partials[worker][hash(term) % num_shards][term];
+                    stats.count += count;
+                    stats.document_frequency += 1;
+                    worker_tokens[worker] += count;
+                }
+            }
+        }, num_threads);
+
+        std::vector<std::vector<std::pair<std::string, TermStats>>> shards(num_shards);
+        PARALLEL::parallel_for(num_shards, [&](size_t begin, size_t end, unsigned int) {
+            METRICS::ScopedTimer reduce_timer("global_terms.reduce");
+            for (size_t s = begin; s < end; ++s) {
+                std::unordered_map<std::string, TermStats> merged = std::move(partials[0][s]);
+                for (size_t worker = 1; worker < partials.size(); ++worker) {
+                    for (auto& [term, stats] : partials[worker][s]) {
+                        TermStats& total = merged[term];
+                        total.count += stats.count;
+                        total.document_frequency += stats.document_frequency;
+                    }
+                    partials[worker][s].clear();
+                }
+                shards[s].assign(std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()));
+                std::sort(shards[s].begin(), shards[s].end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            }
+        }, num_threads);
+
+        std::vector<std::pair<std::string, TermStats>> result;
+        for (std::vector<std::pair<std::string, TermStats>>& shard : shards) {
+            size_t middle = result.size();
+            result.insert(result.end(), std::make_move_iterator(shard.begin()), std::make_move_iterator(shard.end()));
+            std::inplace_merge(result.begin(), result.begin() + middle, result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+
+        summary.files = files.size();
+        for (int64_t n : worker_tokens) summary.tokens += n;
+        summary.distinct_terms = result.size();
+        return result;
+    }
+
+    /**
+     * @brief Count every term over the relation_distance table, for when the token files are gone
+     *
+     * relation_distance only keeps the tokens that passed the per-title filter, so counts of rare
+     * terms are lower than those computed from the token files.
+     *
+     * @throws std::runtime_error if the query cannot be prepared.
+     */
+    std::vector<std::pair<std::string, TermStats>> compute_global_terms(sqlite3* db, GlobalTermsSummary& summary) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT Token, frequency FROM relation_distance ORDER BY Token;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (relation_distance): ") + sqlite3_errmsg(db));
+        }
+        std::vector<std::pair<std::string, TermStats>> result;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* term_text = sqlite3_column_text(stmt, 0);
+            if (!term_text) continue;
+            const char* term = reinterpret_cast<const char*>(term_text);
+            if (result.empty() || result.back().first != term) result.push_back({term, TermStats{}});
+            result.back().second.count += sqlite3_column_int64(stmt, 1);
+            result.back().second.document_frequency += 1;
+            summary.tokens += sqlite3_column_int64(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+        summary.distinct_terms = result.size();
+        return result;
+    }
+
+    /**
+     * @brief Bulk-load the global_terms table in one transaction
+     *
+     * Terms are filtered like the per-title tokens (lowercase letters, ENV_HPP::max_length and
+     * ENV_HPP::min_value); frequency is the share of the term among all counted tokens.
+     *
+     * @param terms (term, stats) pairs, ideally sorted by term so inserts append to the primary key
+     * @param total_tokens The token count frequencies are relative to; 0 means the sum over terms
+     * @throws std::runtime_error if a statement fails; the transaction is rolled back.
+     */
+    void bulk_load_global_terms(sqlite3* db,
+                                const std::vector<std::pair<std::string, TermStats>>& terms,
+                                GlobalTermsSummary& summary,
+                                const bool& reset_table = true,
+                                int64_t total_tokens = 0) {
+        if (reset_table) execute_sql(db, "DROP TABLE IF EXISTS global_terms;");
+        execute_sql(db, R"(
+            CREATE TABLE IF NOT EXISTS global_terms (
+                term TEXT PRIMARY KEY,
+                count INTEGER,
+                frequency REAL,
+                document_frequency INTEGER
+            );
+        )");
+
+        int64_t total = total_tokens;
+        if (total == 0) {
+            for (const auto& [term, stats] : terms) total += stats.count;
+        }
+
+        METRICS::ScopedTimer load_timer("global_terms.bulk_load");
+        execute_sql(db, "PRAGMA synchronous = OFF;");
+        execute_sql(db, "BEGIN TRANSACTION;");
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO global_terms (term, count, frequency, document_frequency) VALUES (?, ?, ?, ?);", -1, &stmt, nullptr) != SQLITE_OK) {
+            std::string message = std::string("Error preparing statement (global_terms): ") + sqlite3_errmsg(db);
+            execute_sql(db, "ROLLBACK TRANSACTION;");
+            throw std::runtime_error(message);
+        }
+        for (const auto& [term, stats] : terms) {
+            if (stats.count < ENV_HPP::min_value || term.length() > static_cast<size_t>(ENV_HPP::max_length) ||
+                !std::all_of(term.begin(), term.end(), [](char c) { return c >= 'a' && c <= 'z'; })) {
+                ++summary.filtered;
+                continue;
+            }
+            sqlite3_bind_text(stmt, 1, term.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, stats.count);
+            sqlite3_bind_double(stmt, 3, static_cast<double>(stats.count) / static_cast<double>(total));
+            if (stats.document_frequency > 0) sqlite3_bind_int64(stmt, 4, stats.document_frequency);
+            else sqlite3_bind_null(stmt, 4);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                std::string message = std::string("Error inserting into global_terms: ") + sqlite3_errmsg(db);
+                sqlite3_finalize(stmt);
+                execute_sql(db, "ROLLBACK TRANSACTION;");
+                throw std::runtime_error(message);
+            }
+            sqlite3_reset(stmt);
+            ++summary.inserted;
+        }
+        sqlite3_finalize(stmt);
+        execute_sql(db, "COMMIT TRANSACTION;");
+        execute_sql(db, "PRAGMA synchronous = FULL;");
+    }
+
+    /**
+     * @brief Load the heavy hitters of a term sketch into global_terms
+     *
+     * Counts are the smaller of the space-saving and count-min estimates, both of which only ever
+     * overestimate; frequencies are relative to the exact number of streamed tokens.
+     */
+    void load_sketched_global_terms(sqlite3* db, const SKETCH::TermSketch& sketch, GlobalTermsSummary& summary, const bool& reset_table = true) {
+        std::vector<std::pair<std::string, TermStats>> terms;
+        for (const auto& [term, counter] : sketch.heavy.top()) {
+            terms.push_back({term, TermStats{
+                .count = std::min(counter.count, sketch.counts.estimate(term)),
+                .document_frequency = sketch.documents.estimate(term),
+            }});
+        }
+        std::sort(terms.begin(), terms.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        summary.tokens = sketch.counts.total_count();
+        summary.distinct_terms = terms.size();
+        bulk_load_global_terms(db, terms, summary, reset_table, sketch.counts.total_count());
+    }
+
+    void print_summary(const GlobalTermsSummary& summary) {
+        std::cout << "Files: " << summary.files << std::endl
+                  << "Tokens: " << summary.tokens << std::endl
+                  << "Distinct terms: " << summary.distinct_terms << std::endl
+                  << "Inserted: " << summary.inserted << std::endl
+                  << "Filtered: " << summary.filtered << std::endl;
+    }
+
+    // Drop and create the file_token and relation_distance tables
+    void create_relational_tables(sqlite3* db) {
+        std::string create_table_sql = R"(
+            DROP TABLE IF EXISTS file_token;
+            CREATE TABLE IF NOT EXISTS file_token (
+                file_name TEXT PRIMARY KEY,
+                total_tokens INTEGER,
+                unique_tokens INTEGER,
+                relational_distance REAL
+            );
+        )";
+        execute_sql(db, create_table_sql);
+
+        create_table_sql = R"(
+            DROP TABLE IF EXISTS relation_distance;
+            CREATE TABLE IF NOT EXISTS relation_distance (
+                file_name TEXT,
+                Token TEXT,
+                frequency INTEGER,
+                relational_distance REAL,
+                PRIMARY KEY (file_name, Token)
+            );
+        )";
+        execute_sql(db, create_table_sql);
+    }
+
+    // Per-title figures of an ingested title, before its filtered tokens are materialized
+    struct TitleFigures {
+        int sum = 0;
+        int num_unique_tokens = 0;
+        double relational_distance = 0.0;
+    };
+
+    /**
+     * @brief Filter the token counts of one title and insert them into file_token and relation_distance
+     *
+     * Terms are views into memory owned by the caller and are bound to the statements without being
+     * copied, so the shared-memory ring can ingest straight out of its records. tokens is filtered
+     * and sorted by term in place, which leaves exactly the rows inserted into relation_distance,
+     * in the order a std::map would insert them.
+     *
+     * @param db The database, ideally inside a transaction
+     * @param path The title's file name, e.g. "title_<id>"
+     * @param tokens The title's token counts, one entry per distinct term
+     */
+    TitleFigures ingest_token_views(sqlite3* db, const std::string_view& path, std::vector<std::pair<std::string_view, int>>& tokens) {
+        METRICS::count("relational_distance.tokens_in", static_cast<int64_t>(tokens.size()));
+        METRICS::ScopedTimer filter_timer("relational_distance.filter");
+        std::erase_if(tokens, [](const std::pair<std::string_view, int>& token) {
+            return token.second < ENV_HPP::min_value || token.first.length() > static_cast<size_t>(ENV_HPP::max_length) ||
+                   !std::all_of(token.first.begin(), token.first.end(), [](char c) { return c >= 'a' && c <= 'z'; });
+        });
+        if (!std::is_sorted(tokens.begin(), tokens.end())) std::sort(tokens.begin(), tokens.end());
+        filter_timer.stop();
+
+        METRICS::ScopedTimer compute_timer("relational_distance.compute");
+        TitleFigures figures = {
+            .sum = TRANSFORMER::compute_sum_token_json(tokens),
+            .num_unique_tokens = TRANSFORMER::count_unique_tokens(tokens),
+            .relational_distance = TRANSFORMER::Pythagoras(tokens),
+        };
+        compute_timer.stop();
+
+        METRICS::ScopedTimer insert_timer("relational_distance.insert");
+        // Insert the row into file_token table using a prepared statement
+        std::string insert_sql = R"(
+            INSERT OR REPLACE INTO file_token (file_name, total_tokens, unique_tokens, relational_distance)
+            VALUES (?, ?, ?, ?);
+        )";
+        sqlite3_stmt* stmt;
+        sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, path.data(), static_cast<int>(path.size()), SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, figures.sum);
+        sqlite3_bind_int(stmt, 3, figures.num_unique_tokens);
+        sqlite3_bind_double(stmt, 4, figures.relational_distance);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+
+        // Insert the filtered tokens into relation_distance table using a prepared statement
+        insert_sql = R"(
+            INSERT OR REPLACE INTO relation_distance (file_name, token, frequency, relational_distance)
+            VALUES (?, ?, ?, ?);
+        )";
+        sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &stmt, nullptr);
+        for (const auto& [term, count] : tokens) {
+            sqlite3_bind_text(stmt, 1, path.data(), static_cast<int>(path.size()), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, term.data(), static_cast<int>(term.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 3, count);
+            sqlite3_bind_double(stmt, 4, static_cast<double>(count) / figures.relational_distance);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt); // Reset the statement for re-use
+        }
+        sqlite3_finalize(stmt);
+        insert_timer.stop();
+
+        METRICS::count("relational_distance.titles");
+        METRICS::count("relational_distance.rows_inserted", static_cast<int64_t>(tokens.size()));
+        return figures;
+    }
+
+    /**
+     * @brief Filter the token counts of one title and insert them into file_token and relation_distance
+     *
+     * @param db The database, ideally inside a transaction
+     * @param path The title's file name, e.g. "title_<id>"
+     * @param json_map The title's token counts
+     * @return The row that was inserted, as dumped to data_dumper.csv and token_filter.csv
+     */
+    DataEntry ingest_token_map(sqlite3* db, const std::string& path, const std::map<std::string, int>& json_map) {
+        std::vector<std::pair<std::string_view, int>> tokens(json_map.begin(), json_map.end());
+        TitleFigures figures = ingest_token_views(db, path, tokens);
+        std::vector<std::tuple<std::string, int, double>> filtered_tokens;
+        filtered_tokens.reserve(tokens.size());
+        for (const auto& [term, count] : tokens) {
+            filtered_tokens.push_back({std::string(term), count, static_cast<double>(count) / figures.relational_distance});
+        }
+        return {
+            .path = path,
+            .sum = figures.sum,
+            .num_unique_tokens = figures.num_unique_tokens,
+            .filtered_tokens = std::move(filtered_tokens),
+            .relational_distance = figures.relational_distance,
+        };
+    }
+
+    // Increment the index generation in index_meta
+    void bump_generation(sqlite3* db) {
+        execute_sql(db, R"(
+            CREATE TABLE IF NOT EXISTS index_meta (key TEXT PRIMARY KEY, value INTEGER);
+            INSERT INTO index_meta (key, value) VALUES ('generation', 1)
+                ON CONFLICT(key) DO UPDATE SET value = value + 1;
+        )");
+    }
+
     /**
      * Compute the relational distance of each token in the given map of strings to
      * integers and store the result in a SQLite database.
@@ -41,13 +381,16 @@ namespace FEATURE {
      * @param show_progress If true, print progress messages to the console.
      * @param reset_table If true, reset the table before adding new data.
      * @param is_dumped If true, dump the data to a file.
+     * @param sketch If set, every title's unfiltered tokens are also streamed into it, so global
+     *               term statistics come out of the same pass in bounded memory.
      *
      * @throws std::runtime_error if the database connection or query fails.
      */
     void computeRelationalDistance(const std::vector<std::filesystem::path>& filtered_files,
                                 const bool show_progress = true,
                                 const bool reset_table = true,
-                                const bool is_dumped = true) {
+                                const bool is_dumped = true,
+                                SKETCH::TermSketch* sketch = nullptr) {
         try {
             // Set up SQLite database connection
             sqlite3* db;
@@ -62,110 +405,74 @@ namespace FEATURE {
 
             // Create tables if reset_table is true
             if (reset_table) {
-                std::string create_table_sql = R"(
-                    DROP TABLE IF EXISTS file_token;
-                    CREATE TABLE IF NOT EXISTS file_token (
-                        file_name TEXT PRIMARY KEY,
-                        total_tokens INTEGER,
-                        unique_tokens INTEGER,
-                        relational_distance REAL
-                    );
-                )";
-                execute_sql(db, create_table_sql);
-
-                create_table_sql = R"(
-                    DROP TABLE IF EXISTS relation_distance;
-                    CREATE TABLE IF NOT EXISTS relation_distance (
-                        file_name TEXT,
-                        Token TEXT,
-                        frequency INTEGER,
-                        relational_distance REAL,
-                        PRIMARY KEY (file_name, Token)
-                    );
-                )";
-                execute_sql(db, create_table_sql);
+                create_relational_tables(db);
                 std::cout << "Tables created successfully" << std::endl;
             }
 
             // Start a transaction to speed up multiple inserts
             execute_sql(db, "BEGIN TRANSACTION;");
 
+            // The dump files stay open for the whole run and are written from a background thread
+            std::optional<DUMP::EntryDumper> dumper;
             bool trigger_once = true;
             for (const std::filesystem::path& file : filtered_files) {
                 if (trigger_once && is_dumped) {
                     trigger_once = false;
                     UTILITIES_HPP::Basic::reset_data_dumper(ENV_HPP::data_dumper_path);
+                    dumper.emplace();
                 }
 
+                const std::string title = file.stem().generic_string();
+                TRACE::Span title_span("relational_distance.title", title);
+                METRICS::ScopedTimer parse_timer("relational_distance.parse");
                 std::map<std::string, int> json_map = TRANSFORMER::json_to_map(file);
-                
-                for (auto it = json_map.begin(); it != json_map.end();) {
-                    const std::string& key = it->first;
-                    const int value = it->second;
-
-                    if (value < ENV_HPP::min_value || key.length() > ENV_HPP::max_length || 
-                        !std::all_of(key.begin(), key.end(), [](char c) { return c >= 'a' && c <= 'z'; })) {
-                        it = json_map.erase(it); // Safely erase invalid entries
-                    } else {
-                        ++it; // Move to the next element
-                    }
-                }
-
-                DataEntry row = {
-                    .path = file.stem().generic_string(),
-                    .sum = TRANSFORMER::compute_sum_token_json(json_map),
-                    .num_unique_tokens = TRANSFORMER::count_unique_tokens(json_map),
-                    .relational_distance = TRANSFORMER::Pythagoras(json_map),
-                };
+                parse_timer.stop();
+                if (sketch) sketch->add_document(json_map);
 
-                // Compute the relational distance of each token
-                // Double gated to filter tokens
-                row.filtered_tokens = TRANSFORMER::token_filter(json_map, ENV_HPP::max_length, ENV_HPP::min_value, row.relational_distance);
+                DataEntry row = ingest_token_map(db, title, std::move(json_map));
 
                 // Dump the contents of a DataEntry to a file
-                if (is_dumped) UTILITIES_HPP::Basic::data_entry_dump(row);
-
-                // Insert the row into file_token table using a prepared statement
-                std::string insert_sql = R"(
-                    INSERT OR REPLACE INTO file_token (file_name, total_tokens, unique_tokens, relational_distance)
-                    VALUES (?, ?, ?, ?);
-                )";
-                sqlite3_stmt* stmt;
-                sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &stmt, nullptr);
-                sqlite3_bind_text(stmt, 1, row.path.c_str(), -1, SQLITE_STATIC);
-                sqlite3_bind_int(stmt, 2, row.sum);
-                sqlite3_bind_int(stmt, 3, row.num_unique_tokens);
-                sqlite3_bind_double(stmt, 4, row.relational_distance);
-                sqlite3_step(stmt);
-                sqlite3_finalize(stmt);
-
-                // Insert the filtered tokens into relation_distance table using a prepared statement
-                insert_sql = R"(
-                    INSERT OR REPLACE INTO relation_distance (file_name, token, frequency, relational_distance)
-                    VALUES (?, ?, ?, ?);
-                )";
-                sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &stmt, nullptr);
-                for (const auto& token : row.filtered_tokens) {
-                    sqlite3_bind_text(stmt, 1, row.path.c_str(), -1, SQLITE_STATIC);
-                    sqlite3_bind_text(stmt, 2, std::get<0>(token).c_str(), -1, SQLITE_STATIC);
-                    sqlite3_bind_int(stmt, 3, std::get<1>(token));
-                    sqlite3_bind_double(stmt, 4, std::get<2>(token));
-                    sqlite3_step(stmt);
-                    sqlite3_reset(stmt); // Reset the statement for re-use
+                if (dumper) {
+                    METRICS::ScopedTimer dump_timer("relational_distance.dump");
+                    dumper->dump(row);
                 }
-                sqlite3_finalize(stmt);
 
                 if (show_progress) {
                     std::cout << "Processed: " << file << std::endl;
                 }
             }
 
+            // Bump the index generation so long-running readers reload and drop cached results
+            bump_generation(db);
+
+            // Wait for the dump writer to drain
+            if (dumper) {
+                METRICS::ScopedTimer dump_timer("relational_distance.dump");
+                dumper->close();
+            }
+
             // Commit the transaction to apply all inserts
+            METRICS::ScopedTimer commit_timer("relational_distance.commit");
             execute_sql(db, "COMMIT TRANSACTION;");
+            commit_timer.stop();
 
             // Re-enable synchronous mode (optional, depending on your use case)
             execute_sql(db, "PRAGMA synchronous = FULL;");
 
+            // Store the approximate global term statistics gathered along the way
+            if (sketch) {
+                GlobalTermsSummary summary;
+                summary.files = filtered_files.size();
+                try {
+                    load_sketched_global_terms(db, *sketch, summary, reset_table);
+                } catch (...) {
+                    sqlite3_close(db);
+                    throw;
+                }
+                print_summary(summary);
+                SKETCH::print_bounds(*sketch);
+            }
+
             // Close the SQLite database connection
             sqlite3_close(db);
             std::cout << "Computing relational distance data finished" << std::endl;
@@ -235,27 +542,46 @@ namespace FEATURE {
             sqlite3_stmt* stmt;
             sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &stmt, nullptr);
 
+            std::optional<DUMP::InfoDumper> dumper;
             bool trigger_once = true;
             for (const std::filesystem::path& file : filtered_files) {
                 if (trigger_once && is_dumped) {
                     UTILITIES_HPP::Basic::reset_file_info_dumper(ENV_HPP::data_info_path);
+                    dumper.emplace();
                     trigger_once = false;
                 }
 
                 // Process the file
+                const std::string file_name = file.stem().generic_string();
+                TRACE::Span file_span("resource_data.file", file_name);
+                METRICS::ScopedTimer stat_timer("resource_data.stat");
+                const std::string file_path = UTILITIES_HPP::Basic::convertToBackslash(file.generic_string());
+                const int epoch_time = UPDATE_INFO::get_epoch_time(file);
+                stat_timer.stop();
+
+                METRICS::ScopedTimer chunk_timer("resource_data.chunk_lookup");
+                const int chunk_count = UPDATE_INFO::count_chunk_for_each_title(db, file_path);
+                const int starting_id = UPDATE_INFO::get_starting_id(db, file_path);
+                const int ending_id = UPDATE_INFO::get_ending_id(db, file_path);
+                chunk_timer.stop();
+
                 DataInfo entry = {
-                    .file_name = file.stem().generic_string(),
-                    .file_path = UTILITIES_HPP::Basic::convertToBackslash(file.generic_string()),
-                    .epoch_time = UPDATE_INFO::get_epoch_time(file),
-                    .chunk_count = UPDATE_INFO::count_chunk_for_each_title(db, entry.file_path),
-                    .starting_id = UPDATE_INFO::get_starting_id(db, entry.file_path),
-                    .ending_id = UPDATE_INFO::get_ending_id(db, entry.file_path),
+                    .id = UPDATE_INFO::create_unique_id(file_path, epoch_time, chunk_count, starting_id),
+                    .file_name = file_name,
+                    .file_path = file_path,
+                    .epoch_time = epoch_time,
+                    .chunk_count = chunk_count,
+                    .starting_id = starting_id,
+                    .ending_id = ending_id,
                 };
 
-                entry.id = UPDATE_INFO::create_unique_id(entry.file_path, entry.epoch_time, entry.chunk_count, entry.starting_id);
-
                 // Export data info if needed
-                if (is_dumped) UTILITIES_HPP::Basic::data_info_dump(entry);
+                if (dumper) {
+                    METRICS::ScopedTimer dump_timer("resource_data.dump");
+                    dumper->dump(entry);
+                }
+
+                METRICS::ScopedTimer insert_timer("resource_data.insert");
 
                 // Bind the values to the statement
                 sqlite3_bind_text(stmt, 1, entry.id.c_str(), -1, SQLITE_STATIC);
@@ -273,6 +599,8 @@ namespace FEATURE {
 
                 // Reset the statement to use it again
                 sqlite3_reset(stmt);
+                insert_timer.stop();
+                METRICS::count("resource_data.files");
 
                 if (show_progress) {
                     std::cout << "Processed: " << file << std::endl;
@@ -282,8 +610,19 @@ namespace FEATURE {
             // Finalize the prepared statement
             sqlite3_finalize(stmt);
 
+            // file_info ids and names are part of the index too, so readers must reload
+            bump_generation(db);
+
+            // Wait for the dump writer to drain
+            if (dumper) {
+                METRICS::ScopedTimer dump_timer("resource_data.dump");
+                dumper->close();
+            }
+
             // Commit the transaction to apply all inserts
+            METRICS::ScopedTimer commit_timer("resource_data.commit");
             execute_sql(db, "COMMIT TRANSACTION;");
+            commit_timer.stop();
 
             // Re-enable synchronous mode (optional, depending on use case)
             execute_sql(db, "PRAGMA synchronous = FULL;");
@@ -308,6 +647,7 @@ namespace FEATURE {
      */
     void processPrompt(const int& top_n = 100) {
         try {
+            METRICS::ScopedTimer load_timer("prompt.load");
             // Transform the JSON file into a map of processed tokens
             std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
             int distance = TRANSFORMER::Pythagoras(tokens);
@@ -367,8 +707,12 @@ namespace FEATURE {
                 relation_distance_map[file_name][token] = relational_distance;
             }
             sqlite3_finalize(relation_stmt); // Finalize statement after processing
+            load_timer.stop();
+            METRICS::gauge("prompt.terms", static_cast<double>(filtered_tokens.size()));
+            METRICS::gauge("prompt.candidate_titles", static_cast<double>(relation_distance_map.size()));
 
             // Step 3: Process the file_info data and calculate distances using the map
+            METRICS::ScopedTimer score_timer("prompt.score");
             while (sqlite3_step(stmt) == SQLITE_ROW) {
                 const unsigned char* id_text = sqlite3_column_text(stmt, 0);
                 const unsigned char* file_name_text = sqlite3_column_text(stmt, 1);
@@ -399,13 +743,18 @@ namespace FEATURE {
             // Finalize statement and close the database
             sqlite3_finalize(stmt);
             sqlite3_close(db);
+            score_timer.stop();
+            METRICS::count("prompt.titles_scored", static_cast<int64_t>(RESULT.size()));
 
             // Sort the results by the largest relative distance
+            METRICS::ScopedTimer sort_timer("prompt.sort");
             std::sort(RESULT.begin(), RESULT.end(), [](const std::tuple<std::string, std::string, double>& a, const std::tuple<std::string, std::string, double>& b) {
                 return std::get<2>(a) > std::get<2>(b);
             });
+            sort_timer.stop();
 
             // Print the first top results
+            METRICS::ScopedTimer print_timer("prompt.print");
             std::cout << "Top "<< top_n <<" Results:" << std::endl
                 << "-----------------------------------------------------------------" << std::endl;
             for (int i = 0; i < top_n && i < RESULT.size(); i++) {
@@ -420,82 +769,78 @@ namespace FEATURE {
     }
 
 
+    /**
+     * @brief Store a ready-made map of global term counts in the global_terms table
+     *
+     * Document frequencies are not known from the map and are stored as NULL.
+     */
     void createGlobalTermsTable(const std::map<std::string, int>& global_terms,
-                                const bool& show_progress = true, 
+                                const bool& show_progress = true,
                                 const bool& reset_table = true) {
         try {
-            // Connect to the database
             sqlite3* db;
-            int exit = sqlite3_open(ENV_HPP::database_path.string().c_str(), &db);
-            if (exit != SQLITE_OK) {
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
                 std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
                 sqlite3_close(db);
                 return;
             }
-            // If reset_table is true, reset the global_terms table
-            if (reset_table) {
-                std::string drop_table_sql = "DROP TABLE IF EXISTS global_terms;";
-                execute_sql(db, drop_table_sql);
+            GlobalTermsSummary summary;
+            std::vector<std::pair<std::string, TermStats>> terms;
+            for (const auto& [term, count] : global_terms) {
+                terms.push_back({term, TermStats{.count = count}});
+                summary.tokens += count;
             }
-
-            // Prepare the SQL statement to create the global_terms table
-            std::string create_table_sql = R"(
-                CREATE TABLE IF NOT EXISTS global_terms (
-                    term TEXT PRIMARY KEY,
-                    count INTEGER,
-                    frequency REAL
-                );
-            )";
-            execute_sql(db, create_table_sql);
-
-            // Prepare the SQL statement to insert data into the global_terms table
-            std::string insert_sql = R"(
-                INSERT INTO global_terms (term, count, frequency) VALUES (?, ?, ?);
-            )";
-            sqlite3_stmt* insert_stmt;
-            exit = sqlite3_prepare_v2(db, insert_sql.c_str(), -1, &insert_stmt, nullptr);
-            if (exit != SQLITE_OK) {
-                std::cerr << "Error preparing statement: " << sqlite3_errmsg(db) << std::endl;
-                sqlite3_finalize(insert_stmt);
+            summary.distinct_terms = terms.size();
+            try {
+                bulk_load_global_terms(db, terms, summary, reset_table);
+            } catch (...) {
                 sqlite3_close(db);
-                return;
+                throw;
             }
+            sqlite3_close(db);
+            if (show_progress) print_summary(summary);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
 
-            // Filter the tokens by maximum length and minimum frequency
-            int total_frequency = 0;
-            for (const auto& entry : global_terms) {
-                total_frequency += entry.second;
+    /**
+     * @brief Compute global term counts and document frequencies natively and load global_terms
+     *
+     * Replaces the global_word_freq.json dump of word_freq.py. Counts come from the token files;
+     * if there are none, from the relation_distance table.
+     */
+    void computeGlobalTerms(const std::vector<std::filesystem::path>& token_files,
+                            const unsigned int& num_threads = PARALLEL::default_threads(),
+                            const bool& reset_table = true) {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+                sqlite3_close(db);
+                return;
             }
-            std::vector<std::tuple<std::string, int, double>> filtered_tokens = token_filter(global_terms, ENV_HPP::max_length, ENV_HPP::min_value, static_cast<double>(total_frequency));
-
-            // Insert data into the global_terms table
-            for (const auto& entry : filtered_tokens) {
-                std::string term = std::get<0>(entry);
-                int count = std::get<1>(entry);
-                double frequency = std::get<2>(entry);
-
-                sqlite3_bind_text(insert_stmt, 1, term.c_str(), -1, SQLITE_STATIC);
-                sqlite3_bind_int(insert_stmt, 2, count);
-                sqlite3_bind_double(insert_stmt, 3, frequency);
-
-                exit = sqlite3_step(insert_stmt);
-                if (exit != SQLITE_DONE) {
-                    std::cerr << "Error inserting data: " << sqlite3_errmsg(db) << std::endl;
-                    sqlite3_finalize(insert_stmt);
-                    sqlite3_close(db);
-                    return;
-                }
-
-                sqlite3_reset(insert_stmt);
-
-                if (show_progress) {
-                    std::cout << "Inserted " << term << " into global_terms table" << std::endl;
-                }
+            GlobalTermsSummary summary;
+            std::chrono::duration<double, std::milli> count_ms, load_ms;
+            try {
+                std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                std::vector<std::pair<std::string, TermStats>> terms = token_files.empty()
+                    ? compute_global_terms(db, summary)
+                    : compute_global_terms(token_files, summary, num_threads);
+                count_ms = std::chrono::steady_clock::now() - start;
+
+                start = std::chrono::steady_clock::now();
+                bulk_load_global_terms(db, terms, summary, reset_table);
+                load_ms = std::chrono::steady_clock::now() - start;
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
             }
-
-            // Finalize the statement and close the database
-            sqlite3_finalize(insert_stmt);
             sqlite3_close(db);
+
+            print_summary(summary);
+            std::cout << "Counted with " << num_threads << " threads in " << count_ms.count() << " ms, "
+                      << "loaded in " << load_ms.count() << " ms" << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "Error: " << e.what() << std::endl;
         }
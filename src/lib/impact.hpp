@@ -0,0 +1,278 @@
+#ifndef IMPACT_HPP
+#define IMPACT_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <stdexcept>
+#include <iostream>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "codec.hpp"
+
+namespace IMPACT {
+
+    // Term weighting model whose per-posting impact is stored in the index
+    enum class Scorer { TfIdf, BM25 };
+
+    const char* scorer_name(const Scorer& scorer) {
+        switch (scorer) {
+            case Scorer::TfIdf: return "tf-idf";
+            case Scorer::BM25: return "bm25";
+        }
+        return "unknown";
+    }
+
+    // BM25 term frequency saturation and length normalisation
+    struct BM25Params {
+        double k1 = 1.2;
+        double b = 0.75;
+    };
+
+    const uint32_t index_magic = 0x49504D49; // "IMPI"
+    const uint32_t index_version = 1;
+
+    /**
+     * @brief Title index with both impacts of every posting, as saved to impact_index.bin
+     *
+     * Postings of term t are [term_offsets[t], term_offsets[t + 1]) of docs, tfidf and bm25.
+     * generation and the BM25 parameters tell whether the saved impacts still match the database.
+     */
+    struct ImpactIndex {
+        std::vector<std::string> ids;
+        std::vector<std::string> file_names;
+        std::vector<std::string> terms;
+        std::vector<uint64_t> term_offsets;
+        std::vector<int32_t> docs;
+        std::vector<double> tfidf;
+        std::vector<double> bm25;
+        int64_t generation = 0;
+        BM25Params params;
+    };
+
+    /**
+     * @brief Read the title lengths (file_token.total_tokens) in document order of the index
+     *
+     * @throws std::runtime_error if the query cannot be prepared.
+     */
+    std::vector<double> load_title_lengths(sqlite3* db, const INDEX::TitleIndex& index) {
+        std::unordered_map<std::string, int> doc_by_file_name;
+        for (size_t doc = 0; doc < index.num_docs(); ++doc) {
+            doc_by_file_name["title_" + index.ids[doc]] = static_cast<int>(doc);
+        }
+
+        std::vector<double> lengths(index.num_docs(), 0.0);
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT file_name, total_tokens FROM file_token;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (file_token): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* file_name_text = sqlite3_column_text(stmt, 0);
+            if (!file_name_text) continue;
+            auto doc = doc_by_file_name.find(reinterpret_cast<const char*>(file_name_text));
+            if (doc != doc_by_file_name.end()) lengths[doc->second] = sqlite3_column_double(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+        return lengths;
+    }
+
+    /**
+     * @brief Replace the term frequencies stored in the postings with precomputed impacts
+     *
+     * Document frequencies are the posting list lengths and title lengths come from file_token,
+     * so all statistics refer to the same filtered tokens as relation_distance.
+     *   TF-IDF: (1 + ln tf) * (ln((1 + N) / (1 + df)) + 1)
+     *   BM25:   idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * len / avg_len)),
+     *           idf = ln(1 + (N - df + 0.5) / (df + 0.5))
+     *
+     * @param index Title index loaded with frequencies as posting weights
+     * @param lengths Title length of every document
+     */
+    void compute_impacts(INDEX::TitleIndex& index, const std::vector<double>& lengths,
+                         const Scorer& scorer, const BM25Params& params = {}) {
+        const double num_docs = static_cast<double>(index.num_docs());
+        double avg_length = 0.0;
+        for (double length : lengths) avg_length += length;
+        avg_length = (lengths.empty() || avg_length <= 0.0) ? 1.0 : avg_length / lengths.size();
+
+        for (std::vector<INDEX::Posting>& list : index.postings) {
+            const double df = static_cast<double>(list.size());
+            if (scorer == Scorer::TfIdf) {
+                const double idf = std::log((1.0 + num_docs) / (1.0 + df)) + 1.0;
+                for (INDEX::Posting& posting : list) {
+                    posting.weight = (posting.weight > 0.0) ? (1.0 + std::log(posting.weight)) * idf : 0.0;
+                }
+            } else {
+                const double idf = std::log(1.0 + (num_docs - df + 0.5) / (df + 0.5));
+                for (INDEX::Posting& posting : list) {
+                    const double tf = posting.weight;
+                    const double norm = params.k1 * (1.0 - params.b + params.b * lengths[posting.doc] / avg_length);
+                    posting.weight = idf * tf * (params.k1 + 1.0) / (tf + norm);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Compute the impacts of every posting of relation_distance under both scorers
+     *
+     * @throws std::runtime_error if the database cannot be queried.
+     */
+    ImpactIndex build_impact_index(sqlite3* db, const BM25Params& params = {}) {
+        INDEX::TitleIndex bm25 = INDEX::load_title_index(db, "frequency");
+        const std::vector<double> lengths = load_title_lengths(db, bm25);
+        INDEX::TitleIndex tfidf = bm25;
+        compute_impacts(tfidf, lengths, Scorer::TfIdf);
+        compute_impacts(bm25, lengths, Scorer::BM25, params);
+
+        ImpactIndex index;
+        index.generation = bm25.generation;
+        index.params = params;
+        index.term_offsets.reserve(bm25.num_terms() + 1);
+        index.term_offsets.push_back(0);
+        for (size_t t = 0; t < bm25.num_terms(); ++t) {
+            for (size_t i = 0; i < bm25.postings[t].size(); ++i) {
+                index.docs.push_back(bm25.postings[t][i].doc);
+                index.tfidf.push_back(tfidf.postings[t][i].weight);
+                index.bm25.push_back(bm25.postings[t][i].weight);
+            }
+            index.term_offsets.push_back(index.docs.size());
+        }
+        index.ids = std::move(bm25.ids);
+        index.file_names = std::move(bm25.file_names);
+        index.terms = std::move(bm25.terms);
+        return index;
+    }
+
+    // Save the impact index to a binary file
+    void save_impact_index(const ImpactIndex& index, const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open impact index file: " + path.string());
+        }
+        CODEC::write_value(out, index_magic);
+        CODEC::write_value(out, index_version);
+        CODEC::write_value(out, index.generation);
+        CODEC::write_value(out, index.params);
+        CODEC::write_strings(out, index.ids);
+        CODEC::write_strings(out, index.file_names);
+        CODEC::write_strings(out, index.terms);
+        CODEC::write_vector(out, index.term_offsets);
+        CODEC::write_vector(out, index.docs);
+        CODEC::write_vector(out, index.tfidf);
+        CODEC::write_vector(out, index.bm25);
+    }
+
+    // Load the impact index from a binary file written by save_impact_index
+    ImpactIndex load_impact_file(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open impact index file: " + path.string() + ". Run --buildimpactindex first.");
+        }
+        if (CODEC::read_value<uint32_t>(in) != index_magic || CODEC::read_value<uint32_t>(in) != index_version) {
+            throw std::runtime_error("Unsupported impact index file: " + path.string());
+        }
+        ImpactIndex index;
+        index.generation = CODEC::read_value<int64_t>(in);
+        index.params = CODEC::read_value<BM25Params>(in);
+        index.ids = CODEC::read_strings(in);
+        index.file_names = CODEC::read_strings(in);
+        index.terms = CODEC::read_strings(in);
+        index.term_offsets = CODEC::read_vector<uint64_t>(in);
+        index.docs = CODEC::read_vector<int32_t>(in);
+        index.tfidf = CODEC::read_vector<double>(in);
+        index.bm25 = CODEC::read_vector<double>(in);
+        return index;
+    }
+
+    /**
+     * @brief Load the title index with the saved impacts of one scorer as posting weights
+     *
+     * The impacts are read from impact_index.bin. If that file is missing, or was built for another
+     * generation of relation_distance or other BM25 parameters, it is rebuilt and saved once, so
+     * later queries only load and add.
+     *
+     * @throws std::runtime_error if the database cannot be opened or queried.
+     */
+    INDEX::TitleIndex load_impact_index(const Scorer& scorer, const BM25Params& params = {}) {
+        sqlite3* db;
+        if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+            std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            throw std::runtime_error(message);
+        }
+        ImpactIndex impacts;
+        try {
+            const int64_t generation = INDEX::read_generation(db);
+            bool current = false;
+            if (std::filesystem::exists(ENV_HPP::impact_index_path)) {
+                impacts = load_impact_file(ENV_HPP::impact_index_path);
+                current = impacts.generation == generation && impacts.params.k1 == params.k1 && impacts.params.b == params.b;
+            }
+            if (!current) {
+                impacts = build_impact_index(db, params);
+                save_impact_index(impacts, ENV_HPP::impact_index_path);
+            }
+        } catch (...) {
+            sqlite3_close(db);
+            throw;
+        }
+        sqlite3_close(db);
+
+        INDEX::TitleIndex index;
+        index.generation = impacts.generation;
+        index.ids = std::move(impacts.ids);
+        index.file_names = std::move(impacts.file_names);
+        index.terms = std::move(impacts.terms);
+        index.term_ids.reserve(index.terms.size());
+        for (size_t t = 0; t < index.terms.size(); ++t) index.term_ids.emplace(index.terms[t], static_cast<int>(t));
+        const std::vector<double>& weights = (scorer == Scorer::BM25) ? impacts.bm25 : impacts.tfidf;
+        index.postings.resize(index.terms.size());
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            std::vector<INDEX::Posting>& list = index.postings[t];
+            list.reserve(impacts.term_offsets[t + 1] - impacts.term_offsets[t]);
+            for (uint64_t i = impacts.term_offsets[t]; i < impacts.term_offsets[t + 1]; ++i) {
+                list.push_back({impacts.docs[i], weights[i]});
+            }
+        }
+        return index;
+    }
+
+    // Build the impact index from the configured database and save it next to it
+    void buildImpactIndex() {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+                sqlite3_close(db);
+                return;
+            }
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            ImpactIndex index;
+            try {
+                index = build_impact_index(db);
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            save_impact_index(index, ENV_HPP::impact_index_path);
+            std::cout << "Indexed " << index.ids.size() << " titles, " << index.terms.size() << " terms, "
+                      << index.docs.size() << " postings in " << elapsed.count() << " seconds" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // IMPACT_HPP
@@ -0,0 +1,387 @@
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
+#include <iostream>
+#include <cstdint>
+#include <chrono>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "transform.hpp"
+#include "parallel.hpp"
+
+namespace INDEX {
+
+    // One entry of a posting list: a title (document) and its stored relational distance for the term
+    struct Posting {
+        int doc;
+        double weight;
+    };
+
+    /**
+     * @brief Galloping search: first element of the sorted range [begin, end) that is >= target
+     *
+     * Probes 1, 2, 4, ... elements ahead and then binary searches the last step, so advancing a cursor
+     * by k elements costs O(log k) rather than O(log n). Shared by the posting list intersections;
+     * comp(element, target) orders elements against the target, as for std::lower_bound.
+     */
+    template <typename Iterator, typename T, typename Compare = std::less<>>
+    Iterator gallop(Iterator begin, Iterator end, const T& target, Compare comp = {}) {
+        typename std::iterator_traits<Iterator>::difference_type step = 1;
+        Iterator low = begin;
+        while (step < end - begin && comp(begin[step], target)) {
+            low = begin + step;
+            step <<= 1;
+        }
+        return std::lower_bound(low, begin + std::min(step + 1, end - begin), target, comp);
+    }
+
+    /**
+     * @brief In-memory copy of file_info and relation_distance, organised as an inverted index
+     *
+     * Documents are the rows of file_info, numbered in the order they are loaded.
+     * Each term of relation_distance gets a term id and a posting list sorted by document.
+     */
+    struct TitleIndex {
+        std::vector<std::string> ids;
+        std::vector<std::string> file_names;
+        std::unordered_map<std::string, int> term_ids;
+        std::vector<std::string> terms;
+        std::vector<std::vector<Posting>> postings;
+        int64_t generation = 0;
+
+        size_t num_docs() const { return ids.size(); }
+        size_t num_terms() const { return terms.size(); }
+
+        // Return the term id of the given token, or -1 if it is not in the vocabulary
+        int find_term(const std::string& token) const {
+            auto it = term_ids.find(token);
+            return (it == term_ids.end()) ? -1 : it->second;
+        }
+    };
+
+    /**
+     * @brief Read the index generation, which FEATURE::computeRelationalDistance bumps on every run
+     *
+     * @param db The database connection
+     * @return The generation, or 0 if relation_distance has never been computed with a generation
+     */
+    int64_t read_generation(sqlite3* db) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT value FROM index_meta WHERE key = 'generation';", -1, &stmt, nullptr) != SQLITE_OK) {
+            return 0;
+        }
+        int64_t generation = 0;
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            generation = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return generation;
+    }
+
+    /**
+     * @brief Load the title index from an open database
+     *
+     * @param db The database connection
+     * @param weight_column The relation_distance column stored as posting weight
+     * @return The loaded index
+     *
+     * @throws std::runtime_error if either query cannot be prepared.
+     */
+    TitleIndex load_title_index(sqlite3* db, const std::string& weight_column = "relational_distance") {
+        TitleIndex index;
+        index.generation = read_generation(db);
+        std::unordered_map<std::string, int> doc_by_file_name;
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT id, file_name FROM file_info;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (file_info): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* id_text = sqlite3_column_text(stmt, 0);
+            const unsigned char* file_name_text = sqlite3_column_text(stmt, 1);
+            if (!id_text || !file_name_text) continue;
+
+            std::string id = reinterpret_cast<const char*>(id_text);
+            doc_by_file_name["title_" + id] = static_cast<int>(index.ids.size());
+            index.ids.push_back(id);
+            index.file_names.push_back(reinterpret_cast<const char*>(file_name_text));
+        }
+        sqlite3_finalize(stmt);
+
+        std::string sql = "SELECT file_name, Token, " + weight_column + " FROM relation_distance;";
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (relation_distance): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* file_name_text = sqlite3_column_text(stmt, 0);
+            const unsigned char* token_text = sqlite3_column_text(stmt, 1);
+            if (!file_name_text || !token_text) continue;
+
+            auto doc = doc_by_file_name.find(reinterpret_cast<const char*>(file_name_text));
+            if (doc == doc_by_file_name.end()) continue; // Title no longer listed in file_info
+
+            std::string token = reinterpret_cast<const char*>(token_text);
+            auto [term, inserted] = index.term_ids.try_emplace(token, static_cast<int>(index.terms.size()));
+            if (inserted) {
+                index.terms.push_back(token);
+                index.postings.emplace_back();
+            }
+            index.postings[term->second].push_back({doc->second, sqlite3_column_double(stmt, 2)});
+        }
+        sqlite3_finalize(stmt);
+
+        for (std::vector<Posting>& list : index.postings) {
+            std::sort(list.begin(), list.end(), [](const Posting& a, const Posting& b) { return a.doc < b.doc; });
+        }
+        return index;
+    }
+
+    // Open the configured database and load the title index from it
+    TitleIndex load_title_index() {
+        sqlite3* db;
+        if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+            std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            throw std::runtime_error(message);
+        }
+        try {
+            TitleIndex index = load_title_index(db);
+            sqlite3_close(db);
+            return index;
+        } catch (...) {
+            sqlite3_close(db);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Convert raw prompt token counts into weighted query terms
+     *
+     * Uses the same normalisation as FEATURE::processPrompt: every count is divided by
+     * the (truncated) Euclidean norm of the prompt, and tokens are filtered with a
+     * maximum length of 16 and a minimum count of 1.
+     *
+     * @return (token, count, weight) triples, sorted by token
+     */
+    std::vector<std::tuple<std::string, int, double>> prompt_weights(const std::map<std::string, int>& tokens) {
+        int distance = TRANSFORMER::Pythagoras(tokens);
+        return TRANSFORMER::token_filter(tokens, 16, 1, distance);
+    }
+
+    /**
+     * @brief Select the top_n highest scores
+     *
+     * @param scores One score per document
+     * @param top_n The maximum number of results to return
+     * @return (document, score) pairs in descending order of score, ties broken by document order
+     */
+    std::vector<std::pair<int, double>> top_k(const std::vector<double>& scores, const int& top_n) {
+        std::vector<std::pair<int, double>> result(scores.size());
+        for (size_t doc = 0; doc < scores.size(); ++doc) {
+            result[doc] = {static_cast<int>(doc), scores[doc]};
+        }
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(keep);
+        return result;
+    }
+
+    // Below this many postings a query is scored on the calling thread; thread start-up would dominate
+    const size_t parallel_min_postings = 1 << 16;
+
+    // Orders (document, score) pairs best first: higher score, then lower document
+    bool better_result(const std::pair<int, double>& a, const std::pair<int, double>& b) {
+        return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+    }
+
+    /**
+     * @brief Score the documents [begin, end) and keep their top_n in a bounded heap
+     *
+     * Posting lists are sorted by document, so each list is entered by binary search at begin.
+     *
+     * @param query (term id, weight) pairs of the prompt
+     * @return Up to top_n (document, score) pairs, in no particular order
+     */
+    std::vector<std::pair<int, double>> score_range(const TitleIndex& index,
+                                                    const std::vector<std::pair<int, double>>& query,
+                                                    const int& begin,
+                                                    const int& end,
+                                                    const int& top_n) {
+        std::vector<double> scores(end - begin, 0.0);
+        for (const auto& [term, weight] : query) {
+            const std::vector<Posting>& list = index.postings[term];
+            auto it = std::lower_bound(list.begin(), list.end(), begin, [](const Posting& p, int doc) { return p.doc < doc; });
+            for (; it != list.end() && it->doc < end; ++it) {
+                scores[it->doc - begin] += weight * it->weight;
+            }
+        }
+
+        // Min-heap on result quality: the front is the worst result kept so far
+        std::vector<std::pair<int, double>> heap;
+        const size_t keep = static_cast<size_t>(std::max(0, top_n));
+        heap.reserve(std::min(keep, scores.size()));
+        for (int doc = begin; doc < end; ++doc) {
+            std::pair<int, double> result = {doc, scores[doc - begin]};
+            if (heap.size() < keep) {
+                heap.push_back(result);
+                std::push_heap(heap.begin(), heap.end(), better_result);
+            } else if (keep > 0 && better_result(result, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), better_result);
+                heap.back() = result;
+                std::push_heap(heap.begin(), heap.end(), better_result);
+            }
+        }
+        return heap;
+    }
+
+    /**
+     * @brief Score every title against the prompt and return the top_n best titles
+     *
+     * Long prompts are scored in parallel: the document id space is split into one contiguous range
+     * per thread, each range keeps its own top_n, and the partial results are merged. Prompts touching
+     * fewer than parallel_min_postings postings stay on the calling thread. Results are identical
+     * either way.
+     *
+     * @param index The loaded title index
+     * @param tokens The prompt token counts, as stored in buffer.json
+     * @param top_n The maximum number of results to return
+     * @param num_threads The maximum number of threads to score with
+     * @return (document, score) pairs in descending order of score, ties broken by document order
+     */
+    std::vector<std::pair<int, double>> score_prompt(const TitleIndex& index,
+                                                     const std::map<std::string, int>& tokens,
+                                                     const int& top_n = 100,
+                                                     const unsigned int& num_threads = 1) {
+        std::vector<std::pair<int, double>> query;
+        size_t num_postings = 0;
+        for (const auto& [token, count, weight] : prompt_weights(tokens)) {
+            int term = index.find_term(token);
+            if (term < 0) continue;
+            query.push_back({term, weight});
+            num_postings += index.postings[term].size();
+        }
+
+        const unsigned int threads = (num_postings < parallel_min_postings) ? 1 : std::max(1u, num_threads);
+        std::vector<std::vector<std::pair<int, double>>> partial(threads);
+        PARALLEL::parallel_for(index.num_docs(), [&](size_t begin, size_t end, unsigned int worker) {
+            partial[worker] = score_range(index, query, static_cast<int>(begin), static_cast<int>(end), top_n);
+        }, threads);
+
+        std::vector<std::pair<int, double>> result;
+        for (const std::vector<std::pair<int, double>>& part : partial) {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), better_result);
+        result.resize(keep);
+        return result;
+    }
+
+    // A prompt as sent to the server or read from a batch file
+    struct PromptRequest {
+        std::map<std::string, int> tokens;
+        int top_n = ENV_HPP::default_top_n;
+    };
+
+    // Key that marks a request envelope; terms are purely alphabetic, so no token map can contain it
+    const std::string envelope_key = "$request";
+
+    // Whether request is an envelope such as {"$request": "prompt", "tokens": {...}} rather than a plain token map
+    bool is_envelope(const json& request) {
+        return request.is_object() && request.contains(envelope_key);
+    }
+
+    /**
+     * @brief Parse a prompt request
+     *
+     * A request is either a plain token map, as written to buffer.json, or an envelope of the form
+     * {"$request": "prompt", "tokens": {...}, "top_n": 10}.
+     *
+     * @throws nlohmann::json::exception if the token counts are not integers
+     * @throws std::runtime_error if the envelope is not a prompt request
+     */
+    PromptRequest parse_prompt_request(const json& request) {
+        PromptRequest prompt;
+        if (is_envelope(request)) {
+            std::string kind = request[envelope_key].get<std::string>();
+            if (kind != "prompt") throw std::runtime_error("Unknown request: " + kind);
+            prompt.tokens = TRANSFORMER::json_object_to_map(request.value("tokens", json::object()));
+            prompt.top_n = request.value("top_n", ENV_HPP::default_top_n);
+        } else {
+            prompt.tokens = TRANSFORMER::json_object_to_map(request);
+        }
+        return prompt;
+    }
+
+    // Print scored documents in the same format as FEATURE::processPrompt
+    void print_results(const TitleIndex& index, const std::vector<std::pair<int, double>>& results) {
+        std::cout << "Top "<< results.size() <<" Results:" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        for (const auto& [doc, score] : results) {
+            std::cout << "ID: " << index.ids[doc] << std::endl
+            << "Distance: " << score << std::endl
+            << "Name: [[" << index.file_names[doc] << ".pdf]]" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        }
+    }
+
+    // Convert scored documents into a JSON array of {id, file_name, score} objects
+    json results_to_json(const TitleIndex& index, const std::vector<std::pair<int, double>>& results) {
+        json array = json::array();
+        for (const auto& [doc, score] : results) {
+            array.push_back({{"id", index.ids[doc]}, {"file_name", index.file_names[doc]}, {"score", score}});
+        }
+        return array;
+    }
+
+    /**
+     * @brief Process buffer.json with intra-query parallel scoring and print the results
+     *
+     * Also times the prompt at 1, 2, 4, ... threads up to num_threads, so the crossover and the
+     * scaling on long prompts can be checked on the real library.
+     */
+    void processPrompt(const int& top_n, const unsigned int& num_threads) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            TitleIndex index = load_title_index();
+
+            size_t num_postings = 0;
+            for (const auto& [token, count, weight] : prompt_weights(tokens)) {
+                int term = index.find_term(token);
+                if (term >= 0) num_postings += index.postings[term].size();
+            }
+
+            std::vector<std::pair<int, double>> results;
+            std::vector<std::pair<unsigned int, double>> timings;
+            for (unsigned int threads = 1; ; threads = std::min(threads * 2, num_threads)) {
+                std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                results = score_prompt(index, tokens, top_n, threads);
+                timings.push_back({threads, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()});
+                if (threads >= num_threads) break;
+            }
+
+            print_results(index, results);
+            std::cout << "Prompt touches " << num_postings << " postings ("
+                      << ((num_postings < parallel_min_postings) ? "single-threaded" : "parallel") << " above 1 thread)" << std::endl;
+            for (const auto& [threads, us] : timings) {
+                std::cout << threads << " threads: " << us << " us" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // INDEX_HPP
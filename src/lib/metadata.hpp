@@ -0,0 +1,291 @@
+#ifndef METADATA_HPP
+#define METADATA_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <limits>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "index.hpp"
+
+namespace METADATA {
+
+    /**
+     * @brief file_info attributes stored column by column, in document order of a title index
+     *
+     * Predicates scan one contiguous column each, which keeps filter compilation to a few linear
+     * passes over small arrays.
+     */
+    struct DocAttributes {
+        std::vector<std::string> file_paths;  // Backslash separated, as stored by computeResourceData
+        std::vector<int64_t> epoch_times;
+        std::vector<int64_t> chunk_counts;
+
+        size_t size() const { return epoch_times.size(); }
+    };
+
+    /**
+     * @brief Load the file_info columns of the titles of the index
+     *
+     * @throws std::runtime_error if the query cannot be prepared.
+     */
+    DocAttributes load_attributes(sqlite3* db, const INDEX::TitleIndex& index) {
+        std::unordered_map<std::string, int> doc_by_id;
+        for (size_t doc = 0; doc < index.num_docs(); ++doc) doc_by_id[index.ids[doc]] = static_cast<int>(doc);
+
+        DocAttributes attributes;
+        attributes.file_paths.resize(index.num_docs());
+        attributes.epoch_times.assign(index.num_docs(), 0);
+        attributes.chunk_counts.assign(index.num_docs(), 0);
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT id, file_path, epoch_time, chunk_count FROM file_info;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (file_info): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* id_text = sqlite3_column_text(stmt, 0);
+            const unsigned char* path_text = sqlite3_column_text(stmt, 1);
+            if (!id_text) continue;
+            auto doc = doc_by_id.find(reinterpret_cast<const char*>(id_text));
+            if (doc == doc_by_id.end()) continue;
+            attributes.file_paths[doc->second] = path_text ? reinterpret_cast<const char*>(path_text) : "";
+            attributes.epoch_times[doc->second] = sqlite3_column_int64(stmt, 2);
+            attributes.chunk_counts[doc->second] = sqlite3_column_int64(stmt, 3);
+        }
+        sqlite3_finalize(stmt);
+        return attributes;
+    }
+
+    // Fixed-size set of document ids, one bit per document
+    class Bitset {
+    public:
+        explicit Bitset(size_t size = 0, bool value = false)
+            : bits(size), words((size + 63) / 64, value ? ~uint64_t{0} : 0) {
+            if (value) clear_tail();
+        }
+
+        size_t size() const { return bits; }
+        bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+        void set(size_t i) { words[i >> 6] |= uint64_t{1} << (i & 63); }
+
+        size_t count() const {
+            size_t n = 0;
+            for (uint64_t word : words) n += static_cast<size_t>(__builtin_popcountll(word));
+            return n;
+        }
+
+        Bitset& operator&=(const Bitset& other) {
+            for (size_t w = 0; w < words.size(); ++w) words[w] &= other.words[w];
+            return *this;
+        }
+
+        // Call fn(i) for every set bit, in increasing order
+        template <typename Fn>
+        void for_each(const Fn& fn) const {
+            for (size_t w = 0; w < words.size(); ++w) {
+                uint64_t word = words[w];
+                while (word) {
+                    fn((w << 6) + static_cast<size_t>(__builtin_ctzll(word)));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        // Build a bitset from a per-document predicate, 64 documents per word without branches
+        template <typename Predicate>
+        static Bitset from_predicate(size_t size, const Predicate& predicate) {
+            Bitset result(size);
+            for (size_t w = 0; w < result.words.size(); ++w) {
+                uint64_t word = 0;
+                const size_t end = std::min(size, (w + 1) << 6);
+                for (size_t i = w << 6; i < end; ++i) {
+                    word |= static_cast<uint64_t>(predicate(i)) << (i & 63);
+                }
+                result.words[w] = word;
+            }
+            return result;
+        }
+
+    private:
+        size_t bits;
+        std::vector<uint64_t> words;
+
+        void clear_tail() {
+            if (bits & 63) words.back() &= (uint64_t{1} << (bits & 63)) - 1;
+        }
+    };
+
+    /**
+     * @brief Metadata predicates of a prompt; unset bounds do not restrict
+     *
+     * Read from the "where" object of a prompt request:
+     * {"epoch_min": 1700000000, "epoch_max": ..., "added_within_days": 30,
+     *  "path_prefix": "D:\\READING LIST\\Math", "chunk_count_min": 10, "chunk_count_max": 500}
+     */
+    struct Filter {
+        int64_t epoch_min = std::numeric_limits<int64_t>::min();
+        int64_t epoch_max = std::numeric_limits<int64_t>::max();
+        int64_t chunk_count_min = std::numeric_limits<int64_t>::min();
+        int64_t chunk_count_max = std::numeric_limits<int64_t>::max();
+        std::string path_prefix;
+
+        bool empty() const {
+            return epoch_min == std::numeric_limits<int64_t>::min() && epoch_max == std::numeric_limits<int64_t>::max()
+                && chunk_count_min == std::numeric_limits<int64_t>::min() && chunk_count_max == std::numeric_limits<int64_t>::max()
+                && path_prefix.empty();
+        }
+    };
+
+    // Paths are compared with backslash separators, the form file_info stores
+    std::string normalize_path(std::string path) {
+        std::replace(path.begin(), path.end(), '/', '\\');
+        return path;
+    }
+
+    Filter parse_filter(const json& where) {
+        Filter filter;
+        if (where.contains("epoch_min")) filter.epoch_min = where["epoch_min"].get<int64_t>();
+        if (where.contains("epoch_max")) filter.epoch_max = where["epoch_max"].get<int64_t>();
+        if (where.contains("added_within_days")) {
+            int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            filter.epoch_min = std::max(filter.epoch_min, now - where["added_within_days"].get<int64_t>() * 86400);
+        }
+        if (where.contains("chunk_count_min")) filter.chunk_count_min = where["chunk_count_min"].get<int64_t>();
+        if (where.contains("chunk_count_max")) filter.chunk_count_max = where["chunk_count_max"].get<int64_t>();
+        if (where.contains("path_prefix")) filter.path_prefix = normalize_path(where["path_prefix"].get<std::string>());
+        return filter;
+    }
+
+    /**
+     * @brief Compile the filter into the set of documents that satisfy every predicate
+     *
+     * Only the predicates that restrict anything are evaluated, each as one pass over its column.
+     */
+    Bitset compile(const Filter& filter, const DocAttributes& attributes) {
+        Bitset allowed(attributes.size(), true);
+        if (filter.epoch_min != std::numeric_limits<int64_t>::min() || filter.epoch_max != std::numeric_limits<int64_t>::max()) {
+            const int64_t* epochs = attributes.epoch_times.data();
+            allowed &= Bitset::from_predicate(attributes.size(), [&](size_t i) {
+                return (epochs[i] >= filter.epoch_min) & (epochs[i] <= filter.epoch_max);
+            });
+        }
+        if (filter.chunk_count_min != std::numeric_limits<int64_t>::min() || filter.chunk_count_max != std::numeric_limits<int64_t>::max()) {
+            const int64_t* counts = attributes.chunk_counts.data();
+            allowed &= Bitset::from_predicate(attributes.size(), [&](size_t i) {
+                return (counts[i] >= filter.chunk_count_min) & (counts[i] <= filter.chunk_count_max);
+            });
+        }
+        if (!filter.path_prefix.empty()) {
+            allowed &= Bitset::from_predicate(attributes.size(), [&](size_t i) {
+                return attributes.file_paths[i].compare(0, filter.path_prefix.size(), filter.path_prefix) == 0;
+            });
+        }
+        return allowed;
+    }
+
+    /**
+     * @brief Score only the allowed titles against the prompt
+     *
+     * Postings of excluded titles are skipped while accumulating, and top-k selection visits the
+     * allowed titles only, so a selective filter makes the query cheaper rather than adding a pass.
+     *
+     * @return (document, score) pairs in descending order of score, ties broken by document order
+     */
+    std::vector<std::pair<int, double>> score_prompt(const INDEX::TitleIndex& index,
+                                                     const std::map<std::string, int>& tokens,
+                                                     const Bitset& allowed,
+                                                     const int& top_n = 100) {
+        std::vector<double> scores(index.num_docs(), 0.0);
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = index.find_term(token);
+            if (term < 0) continue;
+            for (const INDEX::Posting& posting : index.postings[term]) {
+                if (allowed.test(posting.doc)) scores[posting.doc] += weight * posting.weight;
+            }
+        }
+
+        std::vector<std::pair<int, double>> heap;
+        const size_t keep = static_cast<size_t>(std::max(0, top_n));
+        allowed.for_each([&](size_t doc) {
+            std::pair<int, double> result = {static_cast<int>(doc), scores[doc]};
+            if (heap.size() < keep) {
+                heap.push_back(result);
+                std::push_heap(heap.begin(), heap.end(), INDEX::better_result);
+            } else if (keep > 0 && INDEX::better_result(result, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), INDEX::better_result);
+                heap.back() = result;
+                std::push_heap(heap.begin(), heap.end(), INDEX::better_result);
+            }
+        });
+        std::sort(heap.begin(), heap.end(), INDEX::better_result);
+        return heap;
+    }
+
+    /**
+     * @brief Process buffer.json restricted by its "where" object
+     *
+     * buffer.json is {"$request": "prompt", "tokens": {...}, "top_n": 10, "where": {...}}; see Filter for the predicates.
+     */
+    void processPrompt() {
+        try {
+            std::ifstream file(ENV_HPP::buffer_json_path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open JSON file: " + ENV_HPP::buffer_json_path.string());
+            }
+            json request;
+            file >> request;
+            INDEX::PromptRequest prompt = INDEX::parse_prompt_request(request);
+            Filter filter = (INDEX::is_envelope(request) && request.contains("where")) ? parse_filter(request["where"]) : Filter{};
+
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                throw std::runtime_error(message);
+            }
+            INDEX::TitleIndex index;
+            DocAttributes attributes;
+            try {
+                index = INDEX::load_title_index(db);
+                attributes = load_attributes(db, index);
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            Bitset allowed = compile(filter, attributes);
+            std::chrono::duration<double, std::micro> compile_us = std::chrono::steady_clock::now() - start;
+
+            // Average over repeated runs so the filtered and unfiltered timings see equally warm caches
+            const int repeats = 100;
+            std::vector<std::pair<int, double>> results;
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) results = score_prompt(index, prompt.tokens, allowed, prompt.top_n);
+            std::chrono::duration<double, std::micro> filtered_us = (std::chrono::steady_clock::now() - start) / repeats;
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) INDEX::score_prompt(index, prompt.tokens, prompt.top_n);
+            std::chrono::duration<double, std::micro> unfiltered_us = (std::chrono::steady_clock::now() - start) / repeats;
+
+            INDEX::print_results(index, results);
+            std::cout << allowed.count() << " of " << index.num_docs() << " titles pass the filter" << std::endl
+                      << "Filter compiled in " << compile_us.count() << " us, "
+                      << "scored in " << filtered_us.count() << " us"
+                      << " (unfiltered: " << unfiltered_us.count() << " us)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // METADATA_HPP
@@ -0,0 +1,186 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+#include "trace.hpp"
+
+using json = nlohmann::json;
+
+namespace METRICS {
+
+    // Bumped when fields of the report change meaning
+    const int report_version = 1;
+
+    /**
+     * Scoped timers, counters and gauges for tracking where the time goes in each command.
+     *
+     * Timers and counters are aggregated per thread, so recording only takes the calling thread's
+     * own (uncontended) lock; shards outlive their threads and are merged when the report is built.
+     * Names are keys of the form "<stage>.<step>" and must be string literals, as they are stored
+     * as std::string_view.
+     */
+
+    struct TimerStats {
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t min_ns = UINT64_MAX;
+        uint64_t max_ns = 0;
+
+        void add(const uint64_t& ns) {
+            ++count;
+            total_ns += ns;
+            min_ns = std::min(min_ns, ns);
+            max_ns = std::max(max_ns, ns);
+        }
+
+        void merge(const TimerStats& other) {
+            count += other.count;
+            total_ns += other.total_ns;
+            min_ns = std::min(min_ns, other.min_ns);
+            max_ns = std::max(max_ns, other.max_ns);
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, TimerStats> timers;
+        std::unordered_map<std::string_view, int64_t> counters;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Shard>> shards;
+        std::map<std::string, double> gauges;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    // The calling thread's shard, registered on first use
+    Shard& local_shard() {
+        thread_local std::shared_ptr<Shard> shard = []() {
+            std::shared_ptr<Shard> created = std::make_shared<Shard>();
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().shards.push_back(created);
+            return created;
+        }();
+        return *shard;
+    }
+
+    void record(std::string_view name, const uint64_t& ns) {
+        Shard& shard = local_shard();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.timers[name].add(ns);
+    }
+
+    // Add delta to a monotonic counter
+    void count(std::string_view name, const int64_t& delta = 1) {
+        Shard& shard = local_shard();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.counters[name] += delta;
+    }
+
+    // Set a gauge; the report holds the last value set from any thread
+    void gauge(std::string_view name, const double& value) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().gauges[std::string(name)] = value;
+    }
+
+    /**
+     * @brief Records the time from construction to stop() or destruction under name
+     *
+     * The measurement also becomes a trace span when tracing is enabled.
+     */
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(std::string_view name) : name(name), start(std::chrono::steady_clock::now()) {}
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+        ~ScopedTimer() { stop(); }
+
+        // End the measurement early; later calls do nothing
+        void stop() {
+            if (stopped) return;
+            stopped = true;
+            std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+            record(name, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            if (TRACE::enabled) [[unlikely]] TRACE::complete(name, start, end);
+        }
+
+    private:
+        std::string_view name;
+        std::chrono::time_point<std::chrono::steady_clock> start;
+        bool stopped = false;
+    };
+
+    /**
+     * @brief Merge every thread's shard into a JSON report
+     *
+     * {"timers": {name: {count, total_ms, mean_ms, min_ms, max_ms}}, "counters": {name: value},
+     *  "gauges": {name: value}}, with names in sorted order.
+     */
+    json report() {
+        std::map<std::string, TimerStats> timers;
+        std::map<std::string, int64_t> counters;
+        json result;
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            for (const std::shared_ptr<Shard>& shard : registry().shards) {
+                std::lock_guard<std::mutex> shard_lock(shard->mutex);
+                for (const auto& [name, stats] : shard->timers) timers[std::string(name)].merge(stats);
+                for (const auto& [name, value] : shard->counters) counters[std::string(name)] += value;
+            }
+            result["gauges"] = registry().gauges;
+        }
+        result["timers"] = json::object();
+        for (const auto& [name, stats] : timers) {
+            result["timers"][name] = {
+                {"count", stats.count},
+                {"total_ms", stats.total_ns / 1e6},
+                {"mean_ms", stats.total_ns / 1e6 / std::max<uint64_t>(stats.count, 1)},
+                {"min_ms", stats.min_ns / 1e6},
+                {"max_ms", stats.max_ns / 1e6},
+            };
+        }
+        result["counters"] = counters;
+        return result;
+    }
+
+    /**
+     * @brief Write the report, together with the run information in run, to output_path
+     *
+     * run holds e.g. the command line and total elapsed time.
+     */
+    void write_report(const std::filesystem::path& output_path, json run) {
+        try {
+            std::filesystem::create_directories(output_path.parent_path());
+            json metrics = report();
+            run["report_version"] = report_version;
+            for (const auto& [key, value] : metrics.items()) run[key] = value;
+            std::ofstream out(output_path);
+            if (!out) throw std::runtime_error("Could not open " + output_path.string());
+            out << run.dump(4) << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // METRICS_HPP
@@ -0,0 +1,112 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace PARALLEL {
+
+    // Number of worker threads to use when the caller does not specify one
+    unsigned int default_threads() {
+        unsigned int n = std::thread::hardware_concurrency();
+        return (n == 0) ? 1 : n;
+    }
+
+    /**
+     * @brief A fixed-size pool of worker threads consuming a FIFO task queue
+     *
+     * Tasks are submitted with submit() and executed by the first idle worker.
+     * The destructor drains the queue and joins every worker, so all submitted
+     * tasks are guaranteed to have run once the pool goes out of scope.
+     */
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned int num_threads = default_threads()) {
+            for (unsigned int i = 0; i < std::max(1u, num_threads); ++i) {
+                workers.emplace_back([this]() { worker_loop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            condition.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push(std::move(task));
+            }
+            condition.notify_one();
+        }
+
+        size_t size() const { return workers.size(); }
+
+    private:
+        void worker_loop() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if (stopping && tasks.empty()) return;
+                    task = std::move(tasks.front());
+                    tasks.pop();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+    };
+
+    /**
+     * @brief Split [0, count) into contiguous ranges and run fn(begin, end, worker) on each in parallel
+     *
+     * @param count The number of items to process
+     * @param fn The function to run on each range; worker is the index of the range in [0, num_threads)
+     * @param num_threads The number of ranges, at most count; the calling thread runs the first one
+     */
+    void parallel_for(size_t count,
+                      const std::function<void(size_t, size_t, unsigned int)>& fn,
+                      unsigned int num_threads = default_threads()) {
+        if (count == 0) return;
+        num_threads = static_cast<unsigned int>(std::clamp<size_t>(num_threads, 1, count));
+        if (num_threads == 1) {
+            fn(0, count, 0);
+            return;
+        }
+
+        size_t step = (count + num_threads - 1) / num_threads;
+        std::vector<std::thread> threads;
+        for (unsigned int t = 1; t < num_threads; ++t) {
+            size_t begin = std::min(count, t * step);
+            size_t end = std::min(count, begin + step);
+            threads.emplace_back(fn, begin, end, t);
+        }
+        fn(0, std::min(count, step), 0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+#endif // PARALLEL_HPP
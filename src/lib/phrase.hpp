@@ -0,0 +1,408 @@
+#ifndef PHRASE_HPP
+#define PHRASE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <sqlite3.h>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "codec.hpp"
+#include "tokenizer.hpp"
+#include "parallel.hpp"
+#include "chunk.hpp"
+
+namespace PHRASE {
+
+    const uint32_t index_magic = 0x50534F50; // "POSP"
+    const uint32_t index_version = 1;
+
+    /**
+     * @brief Positional inverted index over pdf_chunks
+     *
+     * Documents are chunks in ascending chunk id order. For every term the postings hold, per document,
+     * varint(gap to the previous document), varint(number of positions) and the delta-coded positions.
+     * Positions count the tokens kept by TOKENIZER::tokenize, so stop words do not break a phrase.
+     */
+    struct PositionalIndex {
+        int64_t generation = 0;
+        std::vector<std::string> title_names;
+        std::vector<int64_t> chunk_ids;
+        std::vector<int32_t> chunk_titles;
+
+        std::vector<std::string> terms;
+        std::unordered_map<std::string, int> term_ids;
+        std::vector<uint32_t> doc_freqs;
+        std::vector<uint64_t> term_offsets;
+        std::vector<uint8_t> postings;
+
+        size_t num_chunks() const { return chunk_ids.size(); }
+        size_t num_terms() const { return terms.size(); }
+
+        int find_term(const std::string& token) const {
+            auto it = term_ids.find(token);
+            return (it == term_ids.end()) ? -1 : it->second;
+        }
+    };
+
+    // Postings of one term decoded into flat arrays: positions of docs[i] are positions[offsets[i], offsets[i + 1])
+    struct DecodedTerm {
+        std::vector<uint32_t> docs;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> positions;
+    };
+
+    DecodedTerm decode_term(const PositionalIndex& index, const int& term) {
+        DecodedTerm decoded;
+        decoded.docs.reserve(index.doc_freqs[term]);
+        decoded.offsets.reserve(index.doc_freqs[term] + 1);
+        decoded.offsets.push_back(0);
+        const uint8_t* p = index.postings.data() + index.term_offsets[term];
+        const uint8_t* end = index.postings.data() + index.term_offsets[term + 1];
+        int64_t doc = -1;
+        while (p < end) {
+            uint64_t gap = CODEC::decode_varint(p);
+            doc = (doc < 0) ? static_cast<int64_t>(gap) - 1 : doc + static_cast<int64_t>(gap);
+            uint64_t count = CODEC::decode_varint(p);
+            uint32_t position = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                position += static_cast<uint32_t>(CODEC::decode_varint(p));
+                decoded.positions.push_back(position);
+            }
+            decoded.docs.push_back(static_cast<uint32_t>(doc));
+            decoded.offsets.push_back(static_cast<uint32_t>(decoded.positions.size()));
+        }
+        return decoded;
+    }
+
+    /**
+     * @brief Count the ordered matches of the phrase terms inside one document
+     *
+     * A match starts at every position of the first term from which the remaining terms can be found
+     * in order within a window of (terms - 1 + slop) positions. With slop 0 this is an exact phrase.
+     * Choosing the earliest next position is optimal for an ordered window, so each term keeps one
+     * forward-moving cursor.
+     */
+    size_t count_matches(const std::vector<std::pair<const uint32_t*, const uint32_t*>>& lists, const uint32_t& slop) {
+        const uint32_t window = static_cast<uint32_t>(lists.size() - 1) + slop;
+        std::vector<const uint32_t*> cursors(lists.size());
+        for (size_t i = 0; i < lists.size(); ++i) cursors[i] = lists[i].first;
+
+        size_t matches = 0;
+        for (const uint32_t* start = lists[0].first; start < lists[0].second; ++start) {
+            uint32_t current = *start;
+            bool matched = true;
+            for (size_t i = 1; i < lists.size(); ++i) {
+                cursors[i] = INDEX::gallop(cursors[i], lists[i].second, current + 1);
+                if (cursors[i] == lists[i].second) return matches;
+                current = *cursors[i];
+                if (current - *start > window) {
+                    matched = false;
+                    break;
+                }
+            }
+            if (matched) ++matches;
+        }
+        return matches;
+    }
+
+    /**
+     * @brief Find the chunks that contain the phrase
+     *
+     * Posting lists are decoded rarest term first; candidate documents come from the rarest list and
+     * are intersected with the others by galloping, then positions are checked only for documents that
+     * contain every term.
+     *
+     * @param index The positional index
+     * @param phrase The phrase tokens, as returned by TOKENIZER::tokenize
+     * @param slop The number of extra positions allowed between the terms; 0 for an exact phrase
+     * @param top_n The maximum number of results to return
+     * @return (chunk, number of matches) pairs in descending order of matches, ties broken by chunk order
+     */
+    std::vector<std::pair<int, size_t>> find_phrase(const PositionalIndex& index,
+                                                    const std::vector<std::string>& phrase,
+                                                    const uint32_t& slop,
+                                                    const int& top_n = 100) {
+        std::vector<std::pair<int, size_t>> result;
+        if (phrase.empty()) return result;
+
+        std::vector<DecodedTerm> decoded;
+        for (const std::string& token : phrase) {
+            int term = index.find_term(token);
+            if (term < 0) return result;
+            decoded.push_back(decode_term(index, term));
+        }
+
+        std::vector<size_t> by_rarity(decoded.size());
+        for (size_t i = 0; i < by_rarity.size(); ++i) by_rarity[i] = i;
+        std::sort(by_rarity.begin(), by_rarity.end(), [&](size_t a, size_t b) { return decoded[a].docs.size() < decoded[b].docs.size(); });
+
+        std::vector<const uint32_t*> cursors(decoded.size());
+        for (size_t i = 0; i < decoded.size(); ++i) cursors[i] = decoded[i].docs.data();
+        std::vector<std::pair<const uint32_t*, const uint32_t*>> lists(decoded.size());
+
+        const DecodedTerm& rarest = decoded[by_rarity[0]];
+        bool exhausted = false;
+        for (size_t r = 0; r < rarest.docs.size() && !exhausted; ++r) {
+            uint32_t doc = rarest.docs[r];
+            bool in_all = true;
+            for (size_t k = 1; k < by_rarity.size() && in_all; ++k) {
+                const DecodedTerm& other = decoded[by_rarity[k]];
+                const uint32_t* end = other.docs.data() + other.docs.size();
+                cursors[by_rarity[k]] = INDEX::gallop(cursors[by_rarity[k]], end, doc);
+                exhausted = (cursors[by_rarity[k]] == end);
+                in_all = !exhausted && (*cursors[by_rarity[k]] == doc);
+            }
+            if (!in_all) continue;
+
+            for (size_t i = 0; i < decoded.size(); ++i) {
+                size_t slot = (i == by_rarity[0]) ? r : static_cast<size_t>(cursors[i] - decoded[i].docs.data());
+                lists[i] = {decoded[i].positions.data() + decoded[i].offsets[slot],
+                            decoded[i].positions.data() + decoded[i].offsets[slot + 1]};
+            }
+            size_t matches = count_matches(lists, slop);
+            if (matches > 0) result.push_back({static_cast<int>(doc), matches});
+        }
+
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(keep);
+        return result;
+    }
+
+    /**
+     * @brief Build the positional index from pdf_chunks
+     *
+     * Chunks are read and tokenized in parallel batches like CHUNK::build_chunk_index.
+     *
+     * @throws std::runtime_error if a query cannot be prepared.
+     */
+    PositionalIndex build_positional_index(sqlite3* db, const size_t& batch_size = 4096) {
+        PositionalIndex index;
+        index.generation = INDEX::read_generation(db);
+
+        std::vector<CHUNK::TitleRange> ranges;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT file_name, starting_id, ending_id FROM file_info;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (file_info): ") + sqlite3_errmsg(db));
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* file_name_text = sqlite3_column_text(stmt, 0);
+            if (!file_name_text) continue;
+            ranges.push_back({sqlite3_column_int64(stmt, 1), sqlite3_column_int64(stmt, 2), static_cast<int32_t>(index.title_names.size())});
+            index.title_names.push_back(reinterpret_cast<const char*>(file_name_text));
+        }
+        sqlite3_finalize(stmt);
+        std::sort(ranges.begin(), ranges.end(), [](const CHUNK::TitleRange& a, const CHUNK::TitleRange& b) { return a.starting_id < b.starting_id; });
+
+        if (sqlite3_prepare_v2(db, "SELECT id, chunk_text FROM pdf_chunks ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Error preparing statement (pdf_chunks): ") + sqlite3_errmsg(db));
+        }
+
+        std::vector<std::vector<uint8_t>> term_postings;
+        std::vector<uint32_t> last_doc;
+        std::vector<std::string> texts;
+        std::vector<std::vector<std::string>> tokens;
+        std::unordered_map<int, std::vector<uint32_t>> positions;
+        bool has_rows = true;
+        while (has_rows) {
+            texts.clear();
+            while (texts.size() < batch_size) {
+                if (sqlite3_step(stmt) != SQLITE_ROW) {
+                    has_rows = false;
+                    break;
+                }
+                const unsigned char* text = sqlite3_column_text(stmt, 1);
+                int64_t chunk_id = sqlite3_column_int64(stmt, 0);
+                index.chunk_ids.push_back(chunk_id);
+                index.chunk_titles.push_back(CHUNK::find_title(ranges, chunk_id));
+                texts.push_back(text ? reinterpret_cast<const char*>(text) : "");
+            }
+
+            tokens.assign(texts.size(), {});
+            PARALLEL::parallel_for(texts.size(), [&](size_t begin, size_t end, unsigned int) {
+                for (size_t i = begin; i < end; ++i) tokens[i] = TOKENIZER::tokenize(texts[i]);
+            });
+
+            uint32_t first_doc = static_cast<uint32_t>(index.chunk_ids.size() - texts.size());
+            for (size_t i = 0; i < texts.size(); ++i) {
+                uint32_t doc = first_doc + static_cast<uint32_t>(i);
+                positions.clear();
+                for (size_t position = 0; position < tokens[i].size(); ++position) {
+                    auto [term, inserted] = index.term_ids.try_emplace(tokens[i][position], static_cast<int>(index.terms.size()));
+                    if (inserted) {
+                        index.terms.push_back(tokens[i][position]);
+                        term_postings.emplace_back();
+                        last_doc.push_back(0);
+                        index.doc_freqs.push_back(0);
+                    }
+                    positions[term->second].push_back(static_cast<uint32_t>(position));
+                }
+                for (const auto& [t, list] : positions) {
+                    // The first posting of a list stores doc + 1 so that every gap is positive
+                    CODEC::encode_varint(term_postings[t], (index.doc_freqs[t] == 0) ? doc + 1 : doc - last_doc[t]);
+                    CODEC::encode_varint(term_postings[t], list.size());
+                    uint32_t previous = 0;
+                    for (uint32_t position : list) {
+                        CODEC::encode_varint(term_postings[t], position - previous);
+                        previous = position;
+                    }
+                    last_doc[t] = doc;
+                    index.doc_freqs[t]++;
+                }
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        index.term_offsets.assign(index.terms.size() + 1, 0);
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            index.term_offsets[t + 1] = index.term_offsets[t] + term_postings[t].size();
+        }
+        index.postings.resize(index.term_offsets.back());
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            std::copy(term_postings[t].begin(), term_postings[t].end(), index.postings.begin() + index.term_offsets[t]);
+        }
+        return index;
+    }
+
+    // Save the positional index to a binary file
+    void save_positional_index(const PositionalIndex& index, const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open positional index file: " + path.string());
+        }
+        CODEC::write_value(out, index_magic);
+        CODEC::write_value(out, index_version);
+        CODEC::write_value(out, index.generation);
+        CODEC::write_strings(out, index.title_names);
+        CODEC::write_vector(out, index.chunk_ids);
+        CODEC::write_vector(out, index.chunk_titles);
+        CODEC::write_strings(out, index.terms);
+        CODEC::write_vector(out, index.doc_freqs);
+        CODEC::write_vector(out, index.term_offsets);
+        CODEC::write_vector(out, index.postings);
+    }
+
+    // Load the positional index from a binary file written by save_positional_index
+    PositionalIndex load_positional_index(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open positional index file: " + path.string() + ". Run --buildpositionalindex first.");
+        }
+        if (CODEC::read_value<uint32_t>(in) != index_magic || CODEC::read_value<uint32_t>(in) != index_version) {
+            throw std::runtime_error("Unsupported positional index file: " + path.string());
+        }
+        PositionalIndex index;
+        index.generation = CODEC::read_value<int64_t>(in);
+        index.title_names = CODEC::read_strings(in);
+        index.chunk_ids = CODEC::read_vector<int64_t>(in);
+        index.chunk_titles = CODEC::read_vector<int32_t>(in);
+        index.terms = CODEC::read_strings(in);
+        index.doc_freqs = CODEC::read_vector<uint32_t>(in);
+        index.term_offsets = CODEC::read_vector<uint64_t>(in);
+        index.postings = CODEC::read_vector<uint8_t>(in);
+        for (size_t t = 0; t < index.terms.size(); ++t) {
+            index.term_ids.emplace(index.terms[t], static_cast<int>(t));
+        }
+        return index;
+    }
+
+    // A phrase query line: the phrase, optionally followed by ~N to allow N extra positions
+    struct PhraseQuery {
+        std::string text;
+        uint32_t slop = 0;
+    };
+
+    PhraseQuery parse_phrase_query(const std::string& line) {
+        PhraseQuery query{line, 0};
+        size_t tilde = line.find_last_of('~');
+        if (tilde != std::string::npos && tilde > 0 && tilde + 1 < line.size() &&
+            std::all_of(line.begin() + tilde + 1, line.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            query.text = line.substr(0, line.find_last_not_of(" \t", tilde - 1) + 1);
+            query.slop = static_cast<uint32_t>(std::stoul(line.substr(tilde + 1)));
+        }
+        return query;
+    }
+
+    // Print matching chunks with their chunk id and title
+    void print_results(const PositionalIndex& index, const std::vector<std::pair<int, size_t>>& results) {
+        std::cout << "Top "<< results.size() <<" Phrase Results:" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        for (const auto& [doc, matches] : results) {
+            int32_t title = index.chunk_titles[doc];
+            std::cout << "Chunk ID: " << index.chunk_ids[doc] << std::endl
+            << "Matches: " << matches << std::endl
+            << "Name: [[" << ((title >= 0) ? index.title_names[title] : "unknown") << ".pdf]]" << std::endl
+            << "-----------------------------------------------------------------" << std::endl;
+        }
+    }
+
+    // Build the positional index from the configured database and save it next to it
+    void buildPositionalIndex() {
+        try {
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+                sqlite3_close(db);
+                return;
+            }
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            PositionalIndex index;
+            try {
+                index = build_positional_index(db);
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            save_positional_index(index, ENV_HPP::positional_index_path);
+            std::cout << "Indexed " << index.num_chunks() << " chunks, " << index.num_terms() << " terms, "
+                      << index.postings.size() << " posting bytes in " << elapsed.count() << " seconds" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Run every phrase of phrase_queries.txt against the saved positional index
+    void processPhrases(const std::filesystem::path& query_path, const int& top_n = 100) {
+        try {
+            std::ifstream in(query_path);
+            if (!in.is_open()) {
+                throw std::runtime_error("Could not open phrase query file: " + query_path.string());
+            }
+            PositionalIndex index = load_positional_index(ENV_HPP::positional_index_path);
+
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+                PhraseQuery query = parse_phrase_query(line);
+                std::vector<std::string> phrase = TOKENIZER::tokenize(query.text, false);
+
+                std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                std::vector<std::pair<int, size_t>> results = find_phrase(index, phrase, query.slop, top_n);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+                std::cout << "Phrase: \"" << query.text << "\" ~" << query.slop << " (";
+                for (size_t i = 0; i < phrase.size(); ++i) std::cout << (i ? " " : "") << phrase[i];
+                std::cout << ")" << std::endl;
+                print_results(index, results);
+                std::cout << "Searched " << index.num_chunks() << " chunks in " << elapsed.count() << " ms" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // PHRASE_HPP
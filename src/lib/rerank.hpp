@@ -0,0 +1,172 @@
+#ifndef RERANK_HPP
+#define RERANK_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "chunk.hpp"
+
+namespace RERANK {
+
+    // Wall-clock time of each stage of a two-stage query, in microseconds
+    struct StageTimings {
+        double title_us = 0.0;
+        double locate_us = 0.0;
+        double chunk_us = 0.0;
+        size_t candidate_titles = 0;
+        size_t scored_chunks = 0;
+    };
+
+    /**
+     * @brief Score the given chunks precisely against the prompt using the forward store
+     *
+     * @param index The chunk index
+     * @param query Prompt (chunk term id, weight) pairs sorted by term id
+     * @param chunks The chunks to score
+     * @param top_n The maximum number of results to return
+     * @return (chunk, score) pairs in descending order of score
+     */
+    std::vector<std::pair<int, double>> score_chunks(const CHUNK::ChunkIndex& index,
+                                                     const std::vector<std::pair<uint32_t, double>>& query,
+                                                     const std::vector<int>& chunks,
+                                                     const int& top_n) {
+        std::vector<std::pair<int, double>> result;
+        result.reserve(chunks.size());
+        for (int chunk : chunks) {
+            // Merge the sorted chunk terms with the sorted prompt terms
+            uint64_t i = index.chunk_offsets[chunk];
+            const uint64_t end = index.chunk_offsets[chunk + 1];
+            size_t q = 0;
+            double score = 0.0;
+            while (i < end && q < query.size()) {
+                if (index.chunk_terms[i] < query[q].first) {
+                    ++i;
+                } else if (query[q].first < index.chunk_terms[i]) {
+                    ++q;
+                } else {
+                    score += query[q].second * index.chunk_counts[i] / index.chunk_norms[chunk];
+                    ++i;
+                    ++q;
+                }
+            }
+            if (score > 0.0) result.push_back({chunk, score});
+        }
+
+        size_t keep = std::min(result.size(), static_cast<size_t>(std::max(0, top_n)));
+        std::partial_sort(result.begin(), result.begin() + keep, result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(keep);
+        return result;
+    }
+
+    /**
+     * @brief Coarse-to-fine retrieval: rank titles first, then re-rank only the chunks of the best titles
+     *
+     * Stage 1 scores titles with the relational distance model of the title index and keeps the
+     * candidate_depth best. Stage 2 locates their chunks through the file_info starting_id/ending_id
+     * range and scores only those chunks.
+     *
+     * @param titles The title index
+     * @param chunks The chunk index
+     * @param tokens The prompt token counts
+     * @param candidate_depth The number of titles passed to stage 2
+     * @param top_n The maximum number of chunks to return
+     * @param timings Filled with the time spent in each stage
+     * @return (chunk, score) pairs in descending order of score
+     */
+    std::vector<std::pair<int, double>> score_prompt(const INDEX::TitleIndex& titles,
+                                                     const CHUNK::ChunkIndex& chunks,
+                                                     const std::map<std::string, int>& tokens,
+                                                     const int& candidate_depth,
+                                                     const int& top_n,
+                                                     StageTimings& timings) {
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        std::vector<std::pair<int, double>> candidates = INDEX::score_prompt(titles, tokens, candidate_depth);
+        std::chrono::time_point<std::chrono::steady_clock> stage = std::chrono::steady_clock::now();
+        timings.title_us = std::chrono::duration<double, std::micro>(stage - start).count();
+
+        // Map candidate titles to their chunk documents; chunk ids are sorted, so each title is one range
+        std::unordered_map<std::string, int> chunk_title_by_id;
+        for (size_t t = 0; t < chunks.title_ids.size(); ++t) {
+            chunk_title_by_id.emplace(chunks.title_ids[t], static_cast<int>(t));
+        }
+        std::vector<int> candidate_chunks;
+        for (const auto& [doc, score] : candidates) {
+            if (score <= 0.0) continue;
+            auto title = chunk_title_by_id.find(titles.ids[doc]);
+            if (title == chunk_title_by_id.end()) continue;
+            auto first = std::lower_bound(chunks.chunk_ids.begin(), chunks.chunk_ids.end(), chunks.title_starting_ids[title->second]);
+            auto last = std::upper_bound(chunks.chunk_ids.begin(), chunks.chunk_ids.end(), chunks.title_ending_ids[title->second]);
+            for (auto it = first; it < last; ++it) {
+                candidate_chunks.push_back(static_cast<int>(it - chunks.chunk_ids.begin()));
+            }
+        }
+
+        std::vector<std::pair<uint32_t, double>> query;
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = chunks.find_term(token);
+            if (term >= 0) query.push_back({static_cast<uint32_t>(term), weight});
+        }
+        std::sort(query.begin(), query.end());
+        start = std::chrono::steady_clock::now();
+        timings.locate_us = std::chrono::duration<double, std::micro>(start - stage).count();
+
+        std::vector<std::pair<int, double>> result = score_chunks(chunks, query, candidate_chunks, top_n);
+        timings.chunk_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        timings.candidate_titles = candidates.size();
+        timings.scored_chunks = candidate_chunks.size();
+        return result;
+    }
+
+    /**
+     * @brief Process buffer.json with two-stage retrieval
+     *
+     * Prints the best chunks, the time spent in each stage, and the recall of the two-stage top results
+     * against exhaustive chunk scoring, so candidate_depth can be tuned for latency against recall.
+     */
+    void processPrompt(const int& candidate_depth, const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            INDEX::TitleIndex titles = INDEX::load_title_index();
+            CHUNK::ChunkIndex chunks = CHUNK::load_chunk_index(ENV_HPP::chunk_index_path);
+            if (chunks.generation != titles.generation) {
+                std::cout << "Warning: chunk index was built for generation " << chunks.generation
+                          << ", title index is at generation " << titles.generation << std::endl;
+            }
+
+            StageTimings timings;
+            std::vector<std::pair<int, double>> results = score_prompt(titles, chunks, tokens, candidate_depth, top_n, timings);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            std::vector<std::pair<int, double>> exhaustive = CHUNK::score_prompt(chunks, tokens, top_n);
+            std::chrono::duration<double, std::micro> exhaustive_us = std::chrono::steady_clock::now() - start;
+
+            std::unordered_set<int> found;
+            for (const auto& [chunk, score] : results) found.insert(chunk);
+            size_t recalled = 0;
+            for (const auto& [chunk, score] : exhaustive) recalled += found.count(chunk);
+
+            CHUNK::print_results(chunks, results);
+            std::cout << "Stage 1 (titles): " << timings.title_us << " us, " << timings.candidate_titles << " candidate titles" << std::endl
+                      << "Chunk lookup: " << timings.locate_us << " us" << std::endl
+                      << "Stage 2 (chunks): " << timings.chunk_us << " us, " << timings.scored_chunks << " of " << chunks.num_chunks() << " chunks scored" << std::endl
+                      << "Total: " << timings.title_us + timings.locate_us + timings.chunk_us << " us"
+                      << " (exhaustive chunk scoring: " << exhaustive_us.count() << " us)" << std::endl
+                      << "Recall against exhaustive top " << exhaustive.size() << ": "
+                      << (exhaustive.empty() ? 1.0 : static_cast<double>(recalled) / exhaustive.size()) << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // RERANK_HPP
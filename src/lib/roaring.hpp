@@ -0,0 +1,557 @@
+#ifndef ROARING_HPP
+#define ROARING_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "metadata.hpp"
+
+namespace ROARING {
+
+    // An array container holds at most this many values; above it a bitmap is smaller
+    const size_t array_max = 4096;
+    const size_t bitmap_words = 1024;
+
+    /**
+     * @brief Values of one 2^16 chunk of a roaring bitmap, in the cheapest of three layouts
+     *
+     * Array: sorted values, for sparse chunks. Bitmap: 1024 words, for dense chunks.
+     * Run: sorted (start, length - 1) pairs, for chunks made of long consecutive ranges.
+     */
+    struct Container {
+        enum class Type : uint8_t { Array, Bitmap, Run };
+        Type type = Type::Array;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bitmap;
+        std::vector<std::pair<uint16_t, uint16_t>> runs;
+
+        bool contains(const uint16_t& value) const {
+            switch (type) {
+                case Type::Array: return std::binary_search(array.begin(), array.end(), value);
+                case Type::Bitmap: return (bitmap[value >> 6] >> (value & 63)) & 1;
+                case Type::Run: {
+                    auto it = std::upper_bound(runs.begin(), runs.end(), value,
+                                               [](uint16_t v, const std::pair<uint16_t, uint16_t>& run) { return v < run.first; });
+                    if (it == runs.begin()) return false;
+                    --it;
+                    return value <= static_cast<uint32_t>(it->first) + it->second;
+                }
+            }
+            return false;
+        }
+
+        // Call fn(value) for every value, in increasing order
+        template <typename Fn>
+        void for_each(const Fn& fn) const {
+            switch (type) {
+                case Type::Array:
+                    for (uint16_t value : array) fn(value);
+                    break;
+                case Type::Bitmap:
+                    for (size_t w = 0; w < bitmap_words; ++w) {
+                        for (uint64_t word = bitmap[w]; word; word &= word - 1) {
+                            fn(static_cast<uint16_t>((w << 6) + __builtin_ctzll(word)));
+                        }
+                    }
+                    break;
+                case Type::Run:
+                    for (const auto& [start, length] : runs) {
+                        for (uint32_t value = start; value <= static_cast<uint32_t>(start) + length; ++value) fn(static_cast<uint16_t>(value));
+                    }
+                    break;
+            }
+        }
+
+        // The values as a 1024-word bitmap, whatever the layout
+        std::vector<uint64_t> to_bitmap() const {
+            if (type == Type::Bitmap) return bitmap;
+            std::vector<uint64_t> words(bitmap_words, 0);
+            if (type == Type::Run) {
+                for (const auto& [start, length] : runs) set_range(words, start, static_cast<uint32_t>(start) + length);
+            } else {
+                for (uint16_t value : array) words[value >> 6] |= uint64_t{1} << (value & 63);
+            }
+            return words;
+        }
+
+        // Set the bits [first, last] of a bitmap, a word at a time
+        static void set_range(std::vector<uint64_t>& words, const uint32_t& first, const uint32_t& last) {
+            uint32_t w_first = first >> 6, w_last = last >> 6;
+            uint64_t head = ~uint64_t{0} << (first & 63);
+            uint64_t tail = ~uint64_t{0} >> (63 - (last & 63));
+            if (w_first == w_last) {
+                words[w_first] |= head & tail;
+                return;
+            }
+            words[w_first] |= head;
+            for (uint32_t w = w_first + 1; w < w_last; ++w) words[w] = ~uint64_t{0};
+            words[w_last] |= tail;
+        }
+
+        // Number of set bits in [first, last] of a bitmap
+        static uint32_t count_range(const std::vector<uint64_t>& words, const uint32_t& first, const uint32_t& last) {
+            uint32_t w_first = first >> 6, w_last = last >> 6;
+            uint64_t head = ~uint64_t{0} << (first & 63);
+            uint64_t tail = ~uint64_t{0} >> (63 - (last & 63));
+            if (w_first == w_last) return static_cast<uint32_t>(__builtin_popcountll(words[w_first] & head & tail));
+            uint32_t n = static_cast<uint32_t>(__builtin_popcountll(words[w_first] & head) + __builtin_popcountll(words[w_last] & tail));
+            for (uint32_t w = w_first + 1; w < w_last; ++w) n += static_cast<uint32_t>(__builtin_popcountll(words[w]));
+            return n;
+        }
+
+        // Build the smallest container from a bitmap
+        static Container from_bitmap(std::vector<uint64_t> words) {
+            Container c;
+            for (uint64_t word : words) c.cardinality += static_cast<uint32_t>(__builtin_popcountll(word));
+            if (c.cardinality > array_max) {
+                c.type = Type::Bitmap;
+                c.bitmap = std::move(words);
+            } else {
+                c.array.reserve(c.cardinality);
+                for (size_t w = 0; w < bitmap_words; ++w) {
+                    for (uint64_t word = words[w]; word; word &= word - 1) {
+                        c.array.push_back(static_cast<uint16_t>((w << 6) + __builtin_ctzll(word)));
+                    }
+                }
+            }
+            return c;
+        }
+
+        // Switch to runs when they take less memory than the current layout
+        void run_optimize() {
+            std::vector<std::pair<uint16_t, uint16_t>> found;
+            bool open = false;
+            uint32_t start = 0, previous = 0;
+            for_each([&](uint16_t value) {
+                if (open && value == previous + 1) {
+                    previous = value;
+                    return;
+                }
+                if (open) found.push_back({static_cast<uint16_t>(start), static_cast<uint16_t>(previous - start)});
+                start = previous = value;
+                open = true;
+            });
+            if (open) found.push_back({static_cast<uint16_t>(start), static_cast<uint16_t>(previous - start)});
+
+            size_t current_bytes = (type == Type::Bitmap) ? bitmap_words * 8 : (type == Type::Array) ? array.size() * 2 : runs.size() * 4;
+            if (found.size() * 4 < current_bytes) {
+                type = Type::Run;
+                runs = std::move(found);
+                array.clear();
+                array.shrink_to_fit();
+                bitmap.clear();
+                bitmap.shrink_to_fit();
+            }
+        }
+    };
+
+    // Size of the intersection of two containers without building it
+    uint32_t and_cardinality(const Container& a, const Container& b) {
+        using Type = Container::Type;
+        if (a.type == Type::Bitmap && b.type == Type::Bitmap) {
+            uint32_t n = 0;
+            for (size_t w = 0; w < bitmap_words; ++w) n += static_cast<uint32_t>(__builtin_popcountll(a.bitmap[w] & b.bitmap[w]));
+            return n;
+        }
+        if (a.type == Type::Array && b.type == Type::Array) {
+            if (a.array.empty() || b.array.empty()) return 0;
+            // Merge only the overlap of the two value ranges; facet values usually cover a narrow range
+            uint16_t first = std::max(a.array.front(), b.array.front());
+            uint16_t last = std::min(a.array.back(), b.array.back());
+            if (first > last) return 0;
+            auto i = std::lower_bound(a.array.begin(), a.array.end(), first);
+            auto j = std::lower_bound(b.array.begin(), b.array.end(), first);
+            auto i_end = std::upper_bound(i, a.array.end(), last);
+            auto j_end = std::upper_bound(j, b.array.end(), last);
+            uint32_t n = 0;
+            if (i_end - i > 4 * (j_end - j) || j_end - j > 4 * (i_end - i)) {
+                // Skewed sizes: every value of the short side gallops through the long side
+                if (i_end - i < j_end - j) {
+                    std::swap(i, j);
+                    std::swap(i_end, j_end);
+                }
+                for (; j != j_end; ++j) {
+                    i = INDEX::gallop(i, i_end, *j);
+                    if (i == i_end) break;
+                    n += (*i == *j);
+                }
+                return n;
+            }
+            while (i != i_end && j != j_end) {
+                uint16_t x = *i, y = *j;
+                n += (x == y);
+                i += (x <= y);
+                j += (y <= x);
+            }
+            return n;
+        }
+        if (a.type == Type::Run && b.type == Type::Run) {
+            uint32_t n = 0;
+            size_t i = 0, j = 0;
+            while (i < a.runs.size() && j < b.runs.size()) {
+                uint32_t a_end = static_cast<uint32_t>(a.runs[i].first) + a.runs[i].second;
+                uint32_t b_end = static_cast<uint32_t>(b.runs[j].first) + b.runs[j].second;
+                uint32_t first = std::max<uint32_t>(a.runs[i].first, b.runs[j].first);
+                uint32_t last = std::min(a_end, b_end);
+                if (first <= last) n += last - first + 1;
+                if (a_end < b_end) ++i; else ++j;
+            }
+            return n;
+        }
+        // Count the array values inside each run with two binary searches
+        if ((a.type == Type::Array && b.type == Type::Run) || (a.type == Type::Run && b.type == Type::Array)) {
+            const Container& small = (a.type == Type::Array) ? a : b;
+            const Container& run = (a.type == Type::Array) ? b : a;
+            uint32_t n = 0;
+            auto it = small.array.begin();
+            for (const auto& [start, length] : run.runs) {
+                it = std::lower_bound(it, small.array.end(), start);
+                if (it == small.array.end()) break;
+                auto end = std::upper_bound(it, small.array.end(), static_cast<uint16_t>(start + length));
+                n += static_cast<uint32_t>(end - it);
+                it = end;
+            }
+            return n;
+        }
+        // Probe the array side against a bitmap
+        if (a.type == Type::Array || b.type == Type::Array) {
+            const Container& small = (a.type == Type::Array) ? a : b;
+            const Container& other = (a.type == Type::Array) ? b : a;
+            uint32_t n = 0;
+            for (uint16_t value : small.array) n += other.contains(value);
+            return n;
+        }
+        // One run container and one bitmap container
+        const Container& run = (a.type == Type::Run) ? a : b;
+        const Container& bits = (a.type == Type::Run) ? b : a;
+        uint32_t n = 0;
+        for (const auto& [start, length] : run.runs) n += Container::count_range(bits.bitmap, start, static_cast<uint32_t>(start) + length);
+        return n;
+    }
+
+    Container and_containers(const Container& a, const Container& b) {
+        using Type = Container::Type;
+        if (a.type == Type::Array || b.type == Type::Array) {
+            const Container& small = (a.type == Type::Array) ? a : b;
+            const Container& other = (a.type == Type::Array) ? b : a;
+            Container c;
+            for (uint16_t value : small.array) {
+                if (other.contains(value)) c.array.push_back(value);
+            }
+            c.cardinality = static_cast<uint32_t>(c.array.size());
+            return c;
+        }
+        std::vector<uint64_t> words = a.to_bitmap();
+        std::vector<uint64_t> other = b.to_bitmap();
+        for (size_t w = 0; w < bitmap_words; ++w) words[w] &= other[w];
+        return Container::from_bitmap(std::move(words));
+    }
+
+    Container or_containers(const Container& a, const Container& b) {
+        std::vector<uint64_t> words = a.to_bitmap();
+        std::vector<uint64_t> other = b.to_bitmap();
+        for (size_t w = 0; w < bitmap_words; ++w) words[w] |= other[w];
+        return Container::from_bitmap(std::move(words));
+    }
+
+    /**
+     * @brief Compressed set of 32-bit document ids
+     *
+     * Ids are split by their high 16 bits into containers kept in key order; each container picks
+     * the array, bitmap or run layout that suits its density.
+     */
+    class RoaringBitmap {
+    public:
+        // Build from sorted, unique ids
+        static RoaringBitmap from_sorted(const std::vector<uint32_t>& ids) {
+            RoaringBitmap result;
+            size_t i = 0;
+            while (i < ids.size()) {
+                uint16_t key = static_cast<uint16_t>(ids[i] >> 16);
+                size_t end = i;
+                while (end < ids.size() && (ids[end] >> 16) == key) ++end;
+                Container c;
+                if (end - i > array_max) {
+                    c.type = Container::Type::Bitmap;
+                    c.bitmap.assign(bitmap_words, 0);
+                    for (size_t k = i; k < end; ++k) c.bitmap[(ids[k] & 0xFFFF) >> 6] |= uint64_t{1} << (ids[k] & 63);
+                } else {
+                    for (size_t k = i; k < end; ++k) c.array.push_back(static_cast<uint16_t>(ids[k] & 0xFFFF));
+                }
+                c.cardinality = static_cast<uint32_t>(end - i);
+                c.run_optimize();
+                result.keys.push_back(key);
+                result.containers.push_back(std::move(c));
+                i = end;
+            }
+            return result;
+        }
+
+        static RoaringBitmap from_bitset(const METADATA::Bitset& bitset) {
+            std::vector<uint32_t> ids;
+            bitset.for_each([&](size_t doc) { ids.push_back(static_cast<uint32_t>(doc)); });
+            return from_sorted(ids);
+        }
+
+        bool contains(const uint32_t& id) const {
+            auto it = std::lower_bound(keys.begin(), keys.end(), static_cast<uint16_t>(id >> 16));
+            return it != keys.end() && *it == (id >> 16) && containers[it - keys.begin()].contains(static_cast<uint16_t>(id & 0xFFFF));
+        }
+
+        uint64_t cardinality() const {
+            uint64_t n = 0;
+            for (const Container& c : containers) n += c.cardinality;
+            return n;
+        }
+
+        // Size of the intersection, without building it
+        uint64_t and_cardinality(const RoaringBitmap& other) const {
+            uint64_t n = 0;
+            size_t i = 0, j = 0;
+            while (i < keys.size() && j < other.keys.size()) {
+                if (keys[i] < other.keys[j]) ++i;
+                else if (other.keys[j] < keys[i]) ++j;
+                else n += ROARING::and_cardinality(containers[i++], other.containers[j++]);
+            }
+            return n;
+        }
+
+        RoaringBitmap operator&(const RoaringBitmap& other) const {
+            RoaringBitmap result;
+            size_t i = 0, j = 0;
+            while (i < keys.size() && j < other.keys.size()) {
+                if (keys[i] < other.keys[j]) ++i;
+                else if (other.keys[j] < keys[i]) ++j;
+                else {
+                    Container c = and_containers(containers[i], other.containers[j]);
+                    if (c.cardinality > 0) {
+                        result.keys.push_back(keys[i]);
+                        result.containers.push_back(std::move(c));
+                    }
+                    ++i;
+                    ++j;
+                }
+            }
+            return result;
+        }
+
+        RoaringBitmap operator|(const RoaringBitmap& other) const {
+            RoaringBitmap result;
+            size_t i = 0, j = 0;
+            while (i < keys.size() || j < other.keys.size()) {
+                if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+                    result.keys.push_back(keys[i]);
+                    result.containers.push_back(containers[i++]);
+                } else if (i == keys.size() || other.keys[j] < keys[i]) {
+                    result.keys.push_back(other.keys[j]);
+                    result.containers.push_back(other.containers[j++]);
+                } else {
+                    result.keys.push_back(keys[i]);
+                    result.containers.push_back(or_containers(containers[i++], other.containers[j++]));
+                }
+            }
+            return result;
+        }
+
+        // Call fn(id) for every id, in increasing order
+        template <typename Fn>
+        void for_each(const Fn& fn) const {
+            for (size_t k = 0; k < keys.size(); ++k) {
+                const uint32_t high = static_cast<uint32_t>(keys[k]) << 16;
+                containers[k].for_each([&](uint16_t low) { fn(high | low); });
+            }
+        }
+
+        // Expand into a dense bitset of the given size, for scoring
+        METADATA::Bitset to_bitset(const size_t& size) const {
+            METADATA::Bitset bitset(size);
+            for_each([&](uint32_t id) { if (id < size) bitset.set(id); });
+            return bitset;
+        }
+
+        size_t bytes() const {
+            size_t n = keys.size() * sizeof(uint16_t);
+            for (const Container& c : containers) n += c.array.size() * 2 + c.bitmap.size() * 8 + c.runs.size() * 4;
+            return n;
+        }
+
+    private:
+        std::vector<uint16_t> keys;
+        std::vector<Container> containers;
+    };
+
+    // Calendar year of a Unix time
+    int epoch_year(const int64_t& epoch_time) {
+        std::chrono::sys_days day = std::chrono::floor<std::chrono::days>(std::chrono::sys_seconds(std::chrono::seconds(epoch_time)));
+        return static_cast<int>(std::chrono::year_month_day(day).year());
+    }
+
+    // Folder of a backslash separated file_path
+    std::string parent_folder(const std::string& path) {
+        size_t slash = path.find_last_of('\\');
+        return (slash == std::string::npos) ? std::string() : path.substr(0, slash);
+    }
+
+    // One document set per facet value, built once per index
+    struct FacetIndex {
+        std::map<std::string, RoaringBitmap> folders;
+        std::map<int, RoaringBitmap> years;
+    };
+
+    FacetIndex build_facets(const METADATA::DocAttributes& attributes) {
+        std::map<std::string, std::vector<uint32_t>> folder_docs;
+        std::map<int, std::vector<uint32_t>> year_docs;
+        for (size_t doc = 0; doc < attributes.size(); ++doc) {
+            folder_docs[parent_folder(attributes.file_paths[doc])].push_back(static_cast<uint32_t>(doc));
+            year_docs[epoch_year(attributes.epoch_times[doc])].push_back(static_cast<uint32_t>(doc));
+        }
+        FacetIndex facets;
+        for (const auto& [folder, docs] : folder_docs) facets.folders.emplace(folder, RoaringBitmap::from_sorted(docs));
+        for (const auto& [year, docs] : year_docs) facets.years.emplace(year, RoaringBitmap::from_sorted(docs));
+        return facets;
+    }
+
+    // Facet counts of a candidate set; values with no candidate are left out
+    struct FacetCounts {
+        std::vector<std::pair<std::string, uint64_t>> folders;
+        std::vector<std::pair<int, uint64_t>> years;
+    };
+
+    FacetCounts count_facets(const FacetIndex& facets, const RoaringBitmap& candidates) {
+        FacetCounts counts;
+        for (const auto& [folder, docs] : facets.folders) {
+            uint64_t n = docs.and_cardinality(candidates);
+            if (n > 0) counts.folders.push_back({folder, n});
+        }
+        for (const auto& [year, docs] : facets.years) {
+            uint64_t n = docs.and_cardinality(candidates);
+            if (n > 0) counts.years.push_back({year, n});
+        }
+        return counts;
+    }
+
+    /**
+     * @brief Process buffer.json with metadata filters and print folder and year facets of the results
+     *
+     * Besides the predicates of METADATA::Filter, the "where" object accepts "folder" (exact parent
+     * folder) and "year", which select facet bitmaps and are intersected with the compiled filter.
+     */
+    void processPrompt() {
+        try {
+            std::ifstream file(ENV_HPP::buffer_json_path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open JSON file: " + ENV_HPP::buffer_json_path.string());
+            }
+            json request;
+            file >> request;
+            INDEX::PromptRequest prompt = INDEX::parse_prompt_request(request);
+            json where = (INDEX::is_envelope(request) && request.contains("where")) ? request["where"] : json::object();
+
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                throw std::runtime_error(message);
+            }
+            INDEX::TitleIndex index;
+            METADATA::DocAttributes attributes;
+            try {
+                index = INDEX::load_title_index(db);
+                attributes = METADATA::load_attributes(db, index);
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+            FacetIndex facets = build_facets(attributes);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            RoaringBitmap allowed = RoaringBitmap::from_bitset(METADATA::compile(METADATA::parse_filter(where), attributes));
+            if (where.contains("folder")) {
+                auto it = facets.folders.find(METADATA::normalize_path(where["folder"].get<std::string>()));
+                allowed = (it == facets.folders.end()) ? RoaringBitmap() : (allowed & it->second);
+            }
+            if (where.contains("year")) {
+                auto it = facets.years.find(where["year"].get<int>());
+                allowed = (it == facets.years.end()) ? RoaringBitmap() : (allowed & it->second);
+            }
+            std::chrono::duration<double, std::micro> filter_us = std::chrono::steady_clock::now() - start;
+
+            std::vector<std::pair<int, double>> results = METADATA::score_prompt(index, prompt.tokens, allowed.to_bitset(index.num_docs()), prompt.top_n);
+
+            start = std::chrono::steady_clock::now();
+            std::vector<uint32_t> result_docs;
+            for (const auto& [doc, score] : results) result_docs.push_back(static_cast<uint32_t>(doc));
+            std::sort(result_docs.begin(), result_docs.end());
+            FacetCounts counts = count_facets(facets, RoaringBitmap::from_sorted(result_docs));
+            std::chrono::duration<double, std::micro> facet_us = std::chrono::steady_clock::now() - start;
+
+            INDEX::print_results(index, results);
+            std::cout << "Folders:" << std::endl;
+            for (const auto& [folder, n] : counts.folders) std::cout << "  " << folder << ": " << n << std::endl;
+            std::cout << "Years:" << std::endl;
+            for (const auto& [year, n] : counts.years) std::cout << "  " << year << ": " << n << std::endl;
+            std::cout << allowed.cardinality() << " of " << index.num_docs() << " titles pass the filter, built in "
+                      << filter_us.count() << " us; facets counted in " << facet_us.count() << " us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * @brief Time facet counting over a synthetic library
+     *
+     * Documents get one of `folders` folders (clustered, as files of a folder are usually added
+     * together) and one of 10 years; the candidate set is a random top-k.
+     */
+    void benchmarkFacets(const size_t& num_docs = 100000, const size_t& folders = 200, const size_t& top_k = 1000) {
+        std::mt19937 rng(7);
+        METADATA::DocAttributes attributes;
+        const int64_t year_seconds = 31556952;
+        for (size_t doc = 0; doc < num_docs; ++doc) {
+            attributes.file_paths.push_back("D:\\READING LIST\\folder" + std::to_string(doc * folders / num_docs) + "\\book.pdf");
+            attributes.epoch_times.push_back(1420070400 + static_cast<int64_t>(rng() % 10) * year_seconds + static_cast<int64_t>(rng() % 1000000));
+            attributes.chunk_counts.push_back(static_cast<int64_t>(rng() % 500));
+        }
+
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        FacetIndex facets = build_facets(attributes);
+        std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+        size_t bytes = 0;
+        for (const auto& [folder, docs] : facets.folders) bytes += docs.bytes();
+        for (const auto& [year, docs] : facets.years) bytes += docs.bytes();
+
+        std::vector<uint32_t> candidates;
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(num_docs - 1));
+        while (candidates.size() < top_k) candidates.push_back(pick(rng));
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        const int repeats = 1000;
+        uint64_t total = 0;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) {
+            FacetCounts counts = count_facets(facets, RoaringBitmap::from_sorted(candidates));
+            for (const auto& [folder, n] : counts.folders) total += n;
+        }
+        std::chrono::duration<double, std::micro> facet_us = (std::chrono::steady_clock::now() - start) / repeats;
+
+        std::cout << num_docs << " documents, " << facets.folders.size() << " folders, " << facets.years.size() << " years" << std::endl
+                  << "Facet bitmaps: " << bytes << " bytes, built in " << build_ms.count() << " ms" << std::endl
+                  << "Facet counts for " << candidates.size() << " candidates: " << facet_us.count() << " us"
+                  << " (" << total / repeats << " counted)" << std::endl;
+    }
+}
+
+#endif // ROARING_HPP
@@ -0,0 +1,342 @@
+#ifndef SCORING_HPP
+#define SCORING_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <variant>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "impact.hpp"
+#include "cosine.hpp"
+
+namespace SCORING {
+
+    // Similarity model of a scoring index
+    enum class Model { Dot, Cosine, BM25, TfIdf };
+
+    const char* model_name(const Model& model) {
+        switch (model) {
+            case Model::Dot: return "dot";
+            case Model::Cosine: return "cosine";
+            case Model::BM25: return "bm25";
+            case Model::TfIdf: return "tf-idf";
+        }
+        return "unknown";
+    }
+
+    /*
+     * Scorer policies. Each one says where its posting values come from, how they are prepared
+     * when the index is built, and how prompt weights are prepared once per query; the inner loop
+     * is the same for all of them.
+     */
+
+    // Relational distance weights against the prompt weights of INDEX::score_prompt
+    struct DotScorer {
+        static constexpr Model model = Model::Dot;
+        static INDEX::TitleIndex load() { return INDEX::load_title_index(); }
+        static void prepare_documents(INDEX::TitleIndex&) {}
+        static void prepare_query(std::vector<std::pair<int, double>>&) {}
+    };
+
+    // Unit-length title and prompt vectors
+    struct CosineScorer {
+        static constexpr Model model = Model::Cosine;
+        static INDEX::TitleIndex load() { return INDEX::load_title_index(); }
+        static void prepare_documents(INDEX::TitleIndex& index) {
+            std::vector<double> norms(index.num_docs(), 0.0);
+            for (const std::vector<INDEX::Posting>& list : index.postings) {
+                for (const INDEX::Posting& posting : list) norms[posting.doc] += posting.weight * posting.weight;
+            }
+            for (std::vector<INDEX::Posting>& list : index.postings) {
+                for (INDEX::Posting& posting : list) {
+                    posting.weight = (norms[posting.doc] > 0.0) ? posting.weight / std::sqrt(norms[posting.doc]) : 0.0;
+                }
+            }
+        }
+        static void prepare_query(std::vector<std::pair<int, double>>& query) {
+            double norm = 0.0;
+            for (const auto& [term, weight] : query) norm += weight * weight;
+            norm = std::sqrt(norm);
+            for (auto& [term, weight] : query) weight = (norm > 0.0) ? weight / norm : 0.0;
+        }
+    };
+
+    // Precomputed impacts summed once per distinct prompt term; no weighting happens at query time
+    template <IMPACT::Scorer S, Model M>
+    struct ImpactScorer {
+        static constexpr Model model = M;
+        static INDEX::TitleIndex load() { return IMPACT::load_impact_index(S); }
+        static void prepare_documents(INDEX::TitleIndex&) {}
+        static void prepare_query(std::vector<std::pair<int, double>>& query) {
+            for (auto& [term, weight] : query) weight = 1.0;
+        }
+    };
+    using BM25Scorer = ImpactScorer<IMPACT::Scorer::BM25, Model::BM25>;
+    using TfIdfScorer = ImpactScorer<IMPACT::Scorer::TfIdf, Model::TfIdf>;
+
+    /**
+     * @brief Term-at-a-time posting arrays with weights stored as Weight and summed as Acc
+     *
+     * Integer weights are quantized with one scale for the whole index, so integer accumulators
+     * can sum contributions of different terms without rescaling inside the loop.
+     */
+    template <typename Scorer, typename Weight, typename Acc>
+    struct TypedIndex {
+        static_assert(std::is_floating_point_v<Weight> == std::is_floating_point_v<Acc>,
+                      "Integer weights need an integer accumulator and floating weights a floating one");
+        using scorer_type = Scorer;
+        using weight_type = Weight;
+        using acc_type = Acc;
+
+        INDEX::TitleIndex source;            // ids, file names and vocabulary; postings are released
+        std::vector<uint64_t> term_offsets;  // Postings of term t are [term_offsets[t], term_offsets[t + 1])
+        std::vector<uint32_t> docs;
+        std::vector<Weight> weights;
+        double scale = 1.0;                  // stored weight = weight / scale
+    };
+
+    template <typename Scorer, typename Weight, typename Acc>
+    TypedIndex<Scorer, Weight, Acc> build_typed_index(INDEX::TitleIndex source) {
+        Scorer::prepare_documents(source);
+        TypedIndex<Scorer, Weight, Acc> index;
+        if constexpr (std::is_integral_v<Weight>) {
+            double max_abs = 0.0;
+            for (const std::vector<INDEX::Posting>& list : source.postings) {
+                for (const INDEX::Posting& posting : list) max_abs = std::max(max_abs, std::abs(posting.weight));
+            }
+            index.scale = (max_abs > 0.0) ? max_abs / std::numeric_limits<Weight>::max() : 1.0;
+        }
+        index.term_offsets.push_back(0);
+        for (const std::vector<INDEX::Posting>& list : source.postings) {
+            for (const INDEX::Posting& posting : list) {
+                index.docs.push_back(static_cast<uint32_t>(posting.doc));
+                if constexpr (std::is_integral_v<Weight>) {
+                    index.weights.push_back(static_cast<Weight>(std::lround(posting.weight / index.scale)));
+                } else {
+                    index.weights.push_back(static_cast<Weight>(posting.weight));
+                }
+            }
+            index.term_offsets.push_back(index.docs.size());
+        }
+        source.postings.clear();
+        source.postings.shrink_to_fit();
+        index.source = std::move(source);
+        return index;
+    }
+
+    // Prompt terms with weights prepared for an accumulator type; integer weights carry their own scale
+    template <typename Acc>
+    struct Query {
+        std::vector<std::pair<int, Acc>> terms;
+        double scale = 1.0;
+    };
+
+    /**
+     * @brief Look up the prompt terms and prepare their weights, once per query
+     *
+     * Integer accumulators get the prompt weights quantized to the range of the stored weight type.
+     */
+    template <typename Scorer, typename Weight, typename Acc>
+    Query<Acc> prepare_query(const TypedIndex<Scorer, Weight, Acc>& index, const std::map<std::string, int>& tokens) {
+        std::vector<std::pair<int, double>> weighted;
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = index.source.find_term(token);
+            if (term >= 0) weighted.push_back({term, weight});
+        }
+        Scorer::prepare_query(weighted);
+
+        Query<Acc> query;
+        if constexpr (std::is_integral_v<Acc>) {
+            double max_abs = 0.0;
+            for (const auto& [term, weight] : weighted) max_abs = std::max(max_abs, std::abs(weight));
+            query.scale = (max_abs > 0.0) ? max_abs / std::numeric_limits<Weight>::max() : 1.0;
+        }
+        for (const auto& [term, weight] : weighted) {
+            if constexpr (std::is_integral_v<Acc>) {
+                query.terms.push_back({term, static_cast<Acc>(std::lround(weight / query.scale))});
+            } else {
+                query.terms.push_back({term, static_cast<Acc>(weight)});
+            }
+        }
+        return query;
+    }
+
+    /**
+     * @brief Accumulate the prepared prompt against every title
+     *
+     * The loop body has no branch on the model or the types; each instantiation compiles to its own
+     * loop over Weight values summed in Acc.
+     *
+     * @return One score per document
+     */
+    template <typename Scorer, typename Weight, typename Acc>
+    std::vector<double> accumulate(const TypedIndex<Scorer, Weight, Acc>& index, const Query<Acc>& query) {
+        std::vector<Acc> acc(index.source.num_docs(), Acc{});
+        const uint32_t* docs = index.docs.data();
+        const Weight* weights = index.weights.data();
+        for (const auto& [term, q] : query.terms) {
+            for (uint64_t i = index.term_offsets[term]; i < index.term_offsets[term + 1]; ++i) {
+                acc[docs[i]] += q * static_cast<Acc>(weights[i]);
+            }
+        }
+
+        std::vector<double> scores(acc.size());
+        const double factor = index.scale * query.scale;
+        for (size_t doc = 0; doc < acc.size(); ++doc) scores[doc] = static_cast<double>(acc[doc]) * factor;
+        return scores;
+    }
+
+    // One instantiation per (model, precision); integer weights pair with int32 accumulators
+    using AnyIndex = std::variant<
+        TypedIndex<DotScorer, double, double>, TypedIndex<DotScorer, float, float>, TypedIndex<DotScorer, int8_t, int32_t>,
+        TypedIndex<CosineScorer, double, double>, TypedIndex<CosineScorer, float, float>, TypedIndex<CosineScorer, int8_t, int32_t>,
+        TypedIndex<BM25Scorer, double, double>, TypedIndex<BM25Scorer, float, float>, TypedIndex<BM25Scorer, int8_t, int32_t>,
+        TypedIndex<TfIdfScorer, double, double>, TypedIndex<TfIdfScorer, float, float>, TypedIndex<TfIdfScorer, int8_t, int32_t>>;
+
+    template <typename Scorer>
+    AnyIndex build_index(const COSINE::Precision& precision) {
+        switch (precision) {
+            case COSINE::Precision::Float32: return build_typed_index<Scorer, float, float>(Scorer::load());
+            case COSINE::Precision::Int8: return build_typed_index<Scorer, int8_t, int32_t>(Scorer::load());
+            default: return build_typed_index<Scorer, double, double>(Scorer::load());
+        }
+    }
+
+    // Load the library and build the scoring index of the given model and precision
+    AnyIndex build_index(const Model& model, const COSINE::Precision& precision) {
+        switch (model) {
+            case Model::Cosine: return build_index<CosineScorer>(precision);
+            case Model::BM25: return build_index<BM25Scorer>(precision);
+            case Model::TfIdf: return build_index<TfIdfScorer>(precision);
+            default: return build_index<DotScorer>(precision);
+        }
+    }
+
+    // Score a prompt; the model and precision are dispatched once here, not per posting
+    std::vector<std::pair<int, double>> score_prompt(const AnyIndex& index, const std::map<std::string, int>& tokens, const int& top_n = 100) {
+        return std::visit([&](const auto& typed) { return INDEX::top_k(accumulate(typed, prepare_query(typed, tokens)), top_n); }, index);
+    }
+
+    const INDEX::TitleIndex& source(const AnyIndex& index) {
+        return std::visit([](const auto& typed) -> const INDEX::TitleIndex& { return typed.source; }, index);
+    }
+
+    /**
+     * @brief Process buffer.json with the given model and precision and print the results
+     *
+     * This is the prompt path of --processpromptbm25 and --processprompttfidf.
+     */
+    void processPrompt(const Model& model, const COSINE::Precision& precision = COSINE::Precision::Float64, const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            AnyIndex index = build_index(model, precision);
+            std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            std::vector<std::pair<int, double>> results = score_prompt(index, tokens, top_n);
+            std::chrono::duration<double, std::micro> query_us = std::chrono::steady_clock::now() - start;
+
+            INDEX::print_results(source(index), results);
+            std::cout << "Scorer: " << model_name(model) << ", " << COSINE::precision_name(precision) << std::endl
+                      << "Index build: " << build_ms.count() << " ms, query: " << query_us.count() << " us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Hand-written double loop over the same arrays, the reference for the abstraction cost
+    std::vector<double> accumulate_by_hand(const TypedIndex<DotScorer, double, double>& index, const Query<double>& query) {
+        std::vector<double> acc(index.source.num_docs(), 0.0);
+        for (const auto& [term, weight] : query.terms) {
+            for (uint64_t i = index.term_offsets[term]; i < index.term_offsets[term + 1]; ++i) {
+                acc[index.docs[i]] += weight * index.weights[i];
+            }
+        }
+        return acc;
+    }
+
+    // Hand-written int8 loop over the same arrays
+    std::vector<double> accumulate_by_hand(const TypedIndex<DotScorer, int8_t, int32_t>& index, const Query<int32_t>& query) {
+        std::vector<int32_t> acc(index.source.num_docs(), 0);
+        for (const auto& [term, weight] : query.terms) {
+            for (uint64_t i = index.term_offsets[term]; i < index.term_offsets[term + 1]; ++i) {
+                acc[index.docs[i]] += weight * index.weights[i];
+            }
+        }
+        std::vector<double> scores(acc.size());
+        const double factor = index.scale * query.scale;
+        for (size_t doc = 0; doc < acc.size(); ++doc) scores[doc] = acc[doc] * factor;
+        return scores;
+    }
+
+    template <typename Fn>
+    double time_per_query_us(const Fn& fn, const int& repeats) {
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        double checksum = 0.0;
+        for (int r = 0; r < repeats; ++r) {
+            std::vector<double> scores = fn();
+            checksum += scores.empty() ? 0.0 : scores.front();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        volatile double sink = checksum;  // Keep the scores observable so the loop is not optimised away
+        (void)sink;
+        return elapsed.count() / repeats;
+    }
+
+    /**
+     * @brief Benchmark every (model, precision) instantiation on buffer.json and compare the dot product
+     * instantiations with hand-written loops over the same arrays
+     */
+    void benchmarkScoring(const int& repeats = 2000) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            const std::vector<Model> models = {Model::Dot, Model::Cosine, Model::BM25, Model::TfIdf};
+            const std::vector<COSINE::Precision> precisions = {COSINE::Precision::Float64, COSINE::Precision::Float32, COSINE::Precision::Int8};
+
+            std::cout << "model, precision, us per query" << std::endl;
+            for (const Model& model : models) {
+                for (const COSINE::Precision& precision : precisions) {
+                    AnyIndex index = build_index(model, precision);
+                    double us = std::visit([&](const auto& typed) {
+                        auto query = prepare_query(typed, tokens);
+                        return time_per_query_us([&]() { return accumulate(typed, query); }, repeats);
+                    }, index);
+                    std::cout << model_name(model) << ", " << COSINE::precision_name(precision) << ", " << us << std::endl;
+                }
+            }
+
+            // Abstraction cost: the templated loop against the same loop written out by hand
+            auto f64 = build_typed_index<DotScorer, double, double>(DotScorer::load());
+            auto i8 = build_typed_index<DotScorer, int8_t, int32_t>(DotScorer::load());
+            Query<double> query_f64 = prepare_query(f64, tokens);
+            Query<int32_t> query_i8 = prepare_query(i8, tokens);
+            if (accumulate(f64, query_f64) != accumulate_by_hand(f64, query_f64) ||
+                accumulate(i8, query_i8) != accumulate_by_hand(i8, query_i8)) {
+                throw std::runtime_error("Templated and hand-written scores differ");
+            }
+
+            double templated_f64 = time_per_query_us([&]() { return accumulate(f64, query_f64); }, repeats);
+            double by_hand_f64 = time_per_query_us([&]() { return accumulate_by_hand(f64, query_f64); }, repeats);
+            double templated_i8 = time_per_query_us([&]() { return accumulate(i8, query_i8); }, repeats);
+            double by_hand_i8 = time_per_query_us([&]() { return accumulate_by_hand(i8, query_i8); }, repeats);
+            std::cout << "dot float64: templated " << templated_f64 << " us, by hand " << by_hand_f64 << " us" << std::endl
+                      << "dot int8: templated " << templated_i8 << " us, by hand " << by_hand_i8 << " us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // SCORING_HPP
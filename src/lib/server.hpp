@@ -0,0 +1,313 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <string>
+#include <filesystem>
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <stop_token>
+#include <nlohmann/json.hpp>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "env.hpp"
+#include "index.hpp"
+#include "cache.hpp"
+#include "parallel.hpp"
+#include "transform.hpp"
+
+namespace SERVER {
+
+    // Set by a signal handler or a shutdown request to stop the accept loop
+    std::atomic<bool> stop_requested{false};
+
+    void request_stop(int) {
+        stop_requested = true;
+    }
+
+    /**
+     * @brief State shared by all connections: the current index and the result cache
+     *
+     * The index is replaced as a whole when its generation changes; requests in flight keep
+     * using the snapshot they started with.
+     */
+    struct ServerState {
+        std::shared_ptr<const INDEX::TitleIndex> index;
+        std::mutex index_mutex;
+        CACHE::ResultCache cache{ENV_HPP::result_cache_capacity};
+
+        std::shared_ptr<const INDEX::TitleIndex> snapshot() {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            return index;
+        }
+
+        void replace(std::shared_ptr<const INDEX::TitleIndex> next) {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            index = std::move(next);
+        }
+    };
+
+    // Reload the index if an ingest or resource update has bumped the generation since it was loaded
+    void reload_if_changed(ServerState& state) {
+        sqlite3* db;
+        if (sqlite3_open_v2(ENV_HPP::database_path.string().c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+            sqlite3_close(db);
+            return;
+        }
+        int64_t generation = INDEX::read_generation(db);
+        if (generation != state.snapshot()->generation) {
+            try {
+                auto next = std::make_shared<const INDEX::TitleIndex>(INDEX::load_title_index(db));
+                std::cout << "Reloaded index generation " << next->generation << ": " << next->num_docs()
+                          << " titles and " << next->num_terms() << " terms" << std::endl;
+                state.replace(std::move(next));
+            } catch (const std::exception& e) {
+                std::cerr << "Error reloading index: " << e.what() << std::endl;
+            }
+        }
+        sqlite3_close(db);
+    }
+
+    /**
+     * @brief Check the index generation once a second until the server or the thread is stopped
+     *
+     * Runs on its own thread, so loading a changed index never holds up accepting and reading
+     * connections or occupies a worker; requests keep using the previous snapshot until the new
+     * one is swapped in.
+     */
+    void reload_loop(std::stop_token stop, ServerState& state) {
+        std::chrono::time_point<std::chrono::steady_clock> last_check = std::chrono::steady_clock::now();
+        while (!stop_requested && !stop.stop_requested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (std::chrono::steady_clock::now() - last_check < std::chrono::seconds(1)) continue;
+            reload_if_changed(state);
+            last_check = std::chrono::steady_clock::now();
+        }
+    }
+
+    /**
+     * @brief Answer one JSON-lines request against the loaded index
+     *
+     * A request is either a plain token map, as written to buffer.json, or an envelope of the form
+     * {"$request": "prompt", "tokens": {...}, "top_n": 10}. The envelopes {"$request": "stats"} and
+     * {"$request": "shutdown"} report the cache counters and stop the server.
+     *
+     * @param state The shared server state
+     * @param line One request line without the trailing newline
+     * @return One response line without the trailing newline
+     */
+    std::string handle_request(ServerState& state, const std::string& line) {
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        json response;
+        try {
+            json request = json::parse(line);
+            if (INDEX::is_envelope(request) && request[INDEX::envelope_key] != "prompt") {
+                std::string kind = request[INDEX::envelope_key].get<std::string>();
+                if (kind == "shutdown") {
+                    stop_requested = true;
+                    response["status"] = "stopping";
+                } else if (kind == "stats") {
+                    response["generation"] = state.snapshot()->generation;
+                    response["cache"] = state.cache.get_stats().to_json();
+                } else {
+                    response["error"] = "Unknown request: " + kind;
+                }
+                return response.dump();
+            }
+
+            std::shared_ptr<const INDEX::TitleIndex> index = state.snapshot();
+            INDEX::PromptRequest prompt = INDEX::parse_prompt_request(request);
+            response["results"] = INDEX::results_to_json(*index, CACHE::score_prompt(state.cache, *index, prompt.tokens, prompt.top_n));
+        } catch (const std::exception& e) {
+            response = {{"error", e.what()}};
+        }
+
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        response["elapsed_us"] = elapsed.count();
+        return response.dump();
+    }
+
+#ifndef _WIN32
+    // Write the whole buffer to the socket, returning false if the client went away
+    bool send_all(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief A client connection: its socket and the request lines it sent that are not answered yet
+     *
+     * The accept loop reads from the socket and queues complete lines; workers answer them one at a
+     * time, in order. The socket is closed once the accept loop has dropped the connection and no
+     * worker still holds it.
+     */
+    struct Connection {
+        int fd;
+        std::string pending;             // Bytes after the last newline; only touched by the accept loop
+        std::mutex mutex;
+        std::deque<std::string> lines;   // Requests waiting for an answer, in arrival order
+        bool busy = false;               // A worker is answering one of the lines
+        std::atomic<bool> broken{false}; // A response could not be sent
+
+        explicit Connection(int fd) : fd(fd) {}
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+        ~Connection() { ::close(fd); }
+    };
+
+    // Answer the oldest waiting line of the connection, then hand the next one back to the pool
+    void answer_next(ServerState& state, PARALLEL::ThreadPool& pool, std::shared_ptr<Connection> connection) {
+        std::string line;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            line = std::move(connection->lines.front());
+            connection->lines.pop_front();
+        }
+        if (!send_all(connection->fd, handle_request(state, line) + "\n")) connection->broken = true;
+
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->broken || stop_requested) connection->lines.clear();
+        if (connection->lines.empty()) {
+            connection->busy = false;
+            return;
+        }
+        // Requeue rather than loop, so a client sending many requests does not hold on to a worker
+        pool.submit([&state, &pool, connection]() { answer_next(state, pool, connection); });
+    }
+
+    // Read what the client sent and queue its complete lines; returns false once the client has gone
+    // or has sent more than max_request_bytes without a newline
+    bool receive(ServerState& state, PARALLEL::ThreadPool& pool, const std::shared_ptr<Connection>& connection) {
+        char buffer[64 * 1024];
+        ssize_t n = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (n <= 0 || connection->broken) return false;
+        connection->pending.append(buffer, static_cast<size_t>(n));
+
+        bool start_worker = false;
+        size_t line_start = 0;
+        size_t newline;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            while ((newline = connection->pending.find('\n', line_start)) != std::string::npos) {
+                std::string line = connection->pending.substr(line_start, newline - line_start);
+                line_start = newline + 1;
+                if (!line.empty()) connection->lines.push_back(std::move(line));
+            }
+            if (!connection->busy && !connection->lines.empty()) {
+                connection->busy = true;
+                start_worker = true;
+            }
+        }
+        connection->pending.erase(0, line_start);
+        if (start_worker) pool.submit([&state, &pool, connection]() { answer_next(state, pool, connection); });
+        return connection->pending.size() <= ENV_HPP::max_request_bytes;
+    }
+#endif
+
+    /**
+     * @brief Load the index once and answer prompt requests over a Unix domain socket
+     *
+     * One thread accepts clients and reads from all of them; each complete request line is handed to
+     * a fixed-size thread pool, so idle clients hold no worker. A client may send any number of
+     * newline-delimited JSON requests; every request gets exactly one JSON response line, in order.
+     * Repeated prompts are answered from an LRU result cache. Once a second a separate thread checks the
+     * index generation and reloads the index when it has changed, which also invalidates the cache.
+     * A client that sends more than ENV_HPP::max_request_bytes without a newline is disconnected.
+     * The server runs until SIGINT/SIGTERM or a {"$request": "shutdown"} request.
+     *
+     * @param socket_path The filesystem path of the socket; an existing file at this path is replaced
+     * @param num_threads The number of worker threads, i.e. the number of requests answered concurrently
+     */
+    void serve(const std::filesystem::path& socket_path, const unsigned int& num_threads = PARALLEL::default_threads()) {
+#ifdef _WIN32
+        std::cerr << "Error: server mode requires a POSIX platform" << std::endl;
+#else
+        try {
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            ServerState state;
+            state.replace(std::make_shared<const INDEX::TitleIndex>(INDEX::load_title_index()));
+            std::chrono::duration<double> load_seconds = std::chrono::steady_clock::now() - start;
+            std::cout << "Loaded " << state.snapshot()->num_docs() << " titles and " << state.snapshot()->num_terms() << " terms in "
+                      << load_seconds.count() << " seconds" << std::endl;
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::string path = socket_path.string();
+            if (path.size() >= sizeof(address.sun_path)) {
+                std::cerr << "Error: socket path is too long: " << path << std::endl;
+                return;
+            }
+            std::copy(path.begin(), path.end(), address.sun_path);
+
+            int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listen_fd < 0) {
+                std::cerr << "Error creating socket" << std::endl;
+                return;
+            }
+            ::unlink(path.c_str());
+            if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listen_fd, 64) < 0) {
+                std::cerr << "Error binding socket: " << path << std::endl;
+                ::close(listen_fd);
+                return;
+            }
+
+            stop_requested = false;
+            std::signal(SIGINT, request_stop);
+            std::signal(SIGTERM, request_stop);
+            std::signal(SIGPIPE, SIG_IGN);
+            std::cout << "Serving on " << path << " with " << num_threads << " workers" << std::endl;
+
+            {
+                PARALLEL::ThreadPool pool(num_threads);
+                std::jthread reloader(reload_loop, std::ref(state)); // Stopped and joined when it goes out of scope
+                std::vector<std::shared_ptr<Connection>> connections;
+                std::vector<pollfd> fds;
+                while (!stop_requested) {
+                    fds.assign(1, pollfd{listen_fd, POLLIN, 0});
+                    for (const std::shared_ptr<Connection>& connection : connections) fds.push_back({connection->fd, POLLIN, 0});
+                    // Wake up periodically to notice stop requests
+                    if (::poll(fds.data(), fds.size(), 200) <= 0) continue;
+
+                    std::vector<std::shared_ptr<Connection>> open;
+                    for (size_t i = 0; i < connections.size(); ++i) {
+                        if (fds[i + 1].revents == 0 || receive(state, pool, connections[i])) open.push_back(std::move(connections[i]));
+                    }
+                    connections = std::move(open);
+                    if (fds[0].revents & POLLIN) {
+                        int client_fd = ::accept(listen_fd, nullptr, nullptr);
+                        if (client_fd >= 0) connections.push_back(std::make_shared<Connection>(client_fd));
+                    }
+                }
+                connections.clear();
+                ::close(listen_fd);
+                ::unlink(path.c_str());
+            } // The pool joins here, after in-flight requests have been answered
+
+            CACHE::CacheStats stats = state.cache.get_stats();
+            std::cout << "Server stopped. Cache hits: " << stats.hits << ", misses: " << stats.misses
+                      << ", hit rate: " << stats.hit_rate() << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+#endif
+    }
+}
+
+#endif // SERVER_HPP
@@ -0,0 +1,568 @@
+#ifndef SHMRING_HPP
+#define SHMRING_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <stdexcept>
+#include <filesystem>
+#include <sqlite3.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "env.hpp"
+#include "feature.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "transform.hpp"
+#include "utilities.hpp"
+
+namespace SHMRING {
+
+    const uint32_t ring_magic = 0x52484d53; // "SMHR"
+    const uint32_t ring_version = 1;
+    // Records start on this boundary, so a padding record always fits in front of the wrap point
+    const uint32_t record_alignment = 16;
+    // Titles ingested per transaction; the ring only frees their space once it is committed
+    const size_t commit_records = 256;
+    // How long a blocked side sleeps before rechecking for dead peers and stop requests
+    const int wait_timeout_ms = 100;
+
+    enum RecordState : uint32_t { Empty = 0, Claimed = 1, Committed = 2 };
+    enum RecordType : uint32_t { Padding = 0, Title = 1, End = 2 };
+
+    /**
+     * @brief Control block at the start of the shared memory object
+     *
+     * tail is where the next record is claimed and head where the oldest record not yet committed
+     * to the database starts; [head, tail) is in use. Fields shared between processes are accessed
+     * with std::atomic_ref; data_seq and space_seq are futex words bumped whenever records are
+     * published or space is freed.
+     */
+    struct RingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+#ifdef __linux__
+        pthread_mutex_t claim_mutex; // Robust, so a producer dying while claiming does not wedge the ring
+#endif
+        alignas(64) uint64_t tail;
+        alignas(64) uint64_t head;
+        alignas(64) uint32_t data_seq;
+        uint32_t space_seq;
+        uint32_t ended_producers;
+        uint32_t consumer_pid;
+    };
+
+    // Every record starts with this header; length includes the header and padding
+    struct RecordHeader {
+        uint32_t state;
+        uint32_t type;
+        uint32_t length;
+        uint32_t pid;
+    };
+
+    // Size of the control block, rounded to a page so the data area is page aligned
+    constexpr size_t header_bytes = (sizeof(RingHeader) + 4095) / 4096 * 4096;
+
+    uint32_t round_up(const size_t& bytes) {
+        return static_cast<uint32_t>((bytes + record_alignment - 1) / record_alignment * record_alignment);
+    }
+
+    /**
+     * @brief Packed size of a title record
+     *
+     * Payload: uint32 name length, uint32 term count, the name, then per term a uint8 length,
+     * a uint32 count (unaligned) and the term bytes. Terms longer than 255 bytes are dropped.
+     */
+    template <typename Terms>
+    size_t title_record_bytes(std::string_view name, const Terms& terms) {
+        size_t bytes = sizeof(RecordHeader) + 2 * sizeof(uint32_t) + name.size();
+        for (const auto& [term, count] : terms) {
+            if (std::string_view(term).size() <= 255) bytes += 1 + sizeof(uint32_t) + std::string_view(term).size();
+        }
+        return round_up(bytes);
+    }
+
+    template <typename Terms>
+    void pack_title(char* out, std::string_view name, const Terms& terms) {
+        uint32_t name_size = static_cast<uint32_t>(name.size());
+        uint32_t num_terms = 0;
+        for (const auto& [term, count] : terms) num_terms += (std::string_view(term).size() <= 255);
+        std::memcpy(out, &name_size, sizeof(uint32_t));
+        std::memcpy(out + 4, &num_terms, sizeof(uint32_t));
+        std::memcpy(out + 8, name.data(), name.size());
+        out += 8 + name.size();
+        for (const auto& [term, count] : terms) {
+            std::string_view view(term);
+            if (view.size() > 255) continue;
+            uint32_t value = static_cast<uint32_t>(count);
+            *out++ = static_cast<char>(view.size());
+            std::memcpy(out, &value, sizeof(uint32_t));
+            std::memcpy(out + 4, view.data(), view.size());
+            out += 4 + view.size();
+        }
+    }
+
+    // A title record as seen by the consumer; views point into shared memory
+    struct TitleView {
+        std::string_view name;
+        std::vector<std::pair<std::string_view, uint32_t>> terms;
+    };
+
+    void unpack_title(const char* in, TitleView& title) {
+        uint32_t name_size, num_terms;
+        std::memcpy(&name_size, in, sizeof(uint32_t));
+        std::memcpy(&num_terms, in + 4, sizeof(uint32_t));
+        title.name = std::string_view(in + 8, name_size);
+        in += 8 + name_size;
+        title.terms.clear();
+        for (uint32_t i = 0; i < num_terms; ++i) {
+            size_t size = static_cast<unsigned char>(*in++);
+            uint32_t count;
+            std::memcpy(&count, in, sizeof(uint32_t));
+            title.terms.push_back({std::string_view(in + 4, size), count});
+            in += 4 + size;
+        }
+    }
+
+#ifdef __linux__
+    void futex_wait(uint32_t* word, const uint32_t& expected, const int& timeout_ms) {
+        timespec timeout = {.tv_sec = timeout_ms / 1000, .tv_nsec = (timeout_ms % 1000) * 1000000L};
+        syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    }
+
+    void futex_wake(uint32_t* word) {
+        syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    bool process_alive(const uint32_t& pid) {
+        return pid != 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+    }
+
+    /**
+     * @brief A multi-producer, single-consumer ring of variable-size records in POSIX shared memory
+     *
+     * Producers claim space under a robust process-shared mutex, which only covers advancing tail
+     * and writing the record header; the payload is then written outside the lock and published
+     * by setting the record state to Committed. A full ring blocks producers on the space_seq
+     * futex (backpressure) until the consumer frees space.
+     *
+     * Crash recovery: a record claimed by a process that has since died is skipped by the consumer;
+     * a producer dying inside the claim leaves the mutex to the next producer, which marks it
+     * consistent (header and tail are updated in an order that is always consistent). Space is only
+     * released after the consumer's database transaction commits, so a restarted consumer attaches
+     * to the same ring and replays the records from head.
+     */
+    class Ring {
+    public:
+        Ring() = default;
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+        Ring(Ring&& other) noexcept { *this = std::move(other); }
+        Ring& operator=(Ring&& other) noexcept {
+            std::swap(base, other.base);
+            std::swap(mapped_bytes, other.mapped_bytes);
+            return *this;
+        }
+        ~Ring() {
+            if (base) ::munmap(base, mapped_bytes);
+        }
+
+        /**
+         * @brief Create the ring, or recover an existing one of the same capacity
+         *
+         * @param name The shared memory object name, e.g. "/study_ingest"
+         * @param capacity Data bytes, a power of two
+         * @throws std::runtime_error if the object cannot be created or mapped.
+         */
+        static Ring create(const std::string& name, const uint64_t& capacity) {
+            if (capacity < 4096 || (capacity & (capacity - 1)) != 0) throw std::runtime_error("Ring capacity must be a power of two of at least 4096 bytes");
+            int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+            if (fd < 0) throw std::runtime_error("Could not open shared memory " + name + ": " + std::strerror(errno));
+            struct stat info{};
+            ::fstat(fd, &info);
+            const size_t bytes = header_bytes + capacity;
+            bool recover = static_cast<size_t>(info.st_size) == bytes;
+            if (!recover && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Could not size shared memory " + name + ": " + std::strerror(errno));
+            }
+            Ring ring = map(fd, bytes, name);
+            RingHeader* h = ring.header();
+            recover = recover && h->magic == ring_magic && h->version == ring_version && h->capacity == capacity;
+            if (!recover) {
+                std::memset(ring.base, 0, header_bytes);
+                pthread_mutexattr_t attributes;
+                pthread_mutexattr_init(&attributes);
+                pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+                pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+                pthread_mutex_init(&h->claim_mutex, &attributes);
+                pthread_mutexattr_destroy(&attributes);
+                h->capacity = capacity;
+                h->version = ring_version;
+                std::atomic_ref<uint32_t>(h->magic).store(ring_magic, std::memory_order_release);
+            }
+            std::atomic_ref<uint32_t>(h->consumer_pid).store(static_cast<uint32_t>(::getpid()), std::memory_order_release);
+            return ring;
+        }
+
+        /**
+         * @brief Attach to a ring whose consumer is running
+         *
+         * An interrupted consumer leaves its ring behind for the next one to replay, so the object
+         * existing does not mean anyone is consuming it.
+         *
+         * @throws std::runtime_error if the object is not a ring or its consumer has exited.
+         */
+        static Ring attach(const std::string& name) {
+            int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd < 0) throw std::runtime_error("Could not open shared memory " + name + ": " + std::strerror(errno));
+            struct stat info{};
+            ::fstat(fd, &info);
+            if (static_cast<size_t>(info.st_size) <= header_bytes) {
+                ::close(fd);
+                throw std::runtime_error("Shared memory " + name + " is not a ring");
+            }
+            Ring ring = map(fd, static_cast<size_t>(info.st_size), name);
+            const RingHeader* h = ring.header();
+            if (std::atomic_ref<uint32_t>(ring.header()->magic).load(std::memory_order_acquire) != ring_magic
+                || h->version != ring_version || header_bytes + h->capacity != static_cast<size_t>(info.st_size)) {
+                throw std::runtime_error("Shared memory " + name + " is not a ring of version " + std::to_string(ring_version));
+            }
+            if (!process_alive(std::atomic_ref<uint32_t>(ring.header()->consumer_pid).load(std::memory_order_acquire))) {
+                throw std::runtime_error("No consumer is running on shared memory " + name);
+            }
+            return ring;
+        }
+
+        static void unlink(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+        RingHeader* header() const { return reinterpret_cast<RingHeader*>(base); }
+        char* data() const { return static_cast<char*>(base) + header_bytes; }
+        uint64_t capacity() const { return header()->capacity; }
+        RecordHeader* record(const uint64_t& position) const {
+            return reinterpret_cast<RecordHeader*>(data() + (position & (capacity() - 1)));
+        }
+
+        /**
+         * @brief Claim length bytes for a record, blocking while the ring is full
+         *
+         * @return The position of the claimed record, whose state is Claimed, or UINT64_MAX on timeout
+         */
+        uint64_t claim(const uint32_t& type, const uint32_t& length, const int& timeout_ms = -1) {
+            if (length > capacity() / 2) throw std::runtime_error("Record of " + std::to_string(length) + " bytes does not fit the ring");
+            RingHeader* h = header();
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            while (true) {
+                uint32_t space = std::atomic_ref<uint32_t>(h->space_seq).load(std::memory_order_acquire);
+                lock();
+                uint64_t position = std::atomic_ref<uint64_t>(h->tail).load(std::memory_order_relaxed);
+                uint64_t offset = position & (capacity() - 1);
+                uint64_t padding = (offset + length > capacity()) ? capacity() - offset : 0;
+                uint64_t head = std::atomic_ref<uint64_t>(h->head).load(std::memory_order_acquire);
+                if (position + padding + length - head <= capacity()) {
+                    if (padding) {
+                        RecordHeader* pad = record(position);
+                        pad->type = Padding;
+                        pad->length = static_cast<uint32_t>(padding);
+                        pad->pid = static_cast<uint32_t>(::getpid());
+                        std::atomic_ref<uint32_t>(pad->state).store(Committed, std::memory_order_release);
+                        position += padding;
+                    }
+                    RecordHeader* claimed = record(position);
+                    claimed->type = type;
+                    claimed->length = length;
+                    claimed->pid = static_cast<uint32_t>(::getpid());
+                    std::atomic_ref<uint32_t>(claimed->state).store(Claimed, std::memory_order_release);
+                    std::atomic_ref<uint64_t>(h->tail).store(position + length, std::memory_order_release);
+                    pthread_mutex_unlock(&h->claim_mutex);
+                    return position;
+                }
+                pthread_mutex_unlock(&h->claim_mutex);
+                if (timeout_ms >= 0 && std::chrono::steady_clock::now() - start > std::chrono::milliseconds(timeout_ms)) return UINT64_MAX;
+                futex_wait(&h->space_seq, space, wait_timeout_ms);
+            }
+        }
+
+        // Publish a claimed record to the consumer
+        void publish(const uint64_t& position) {
+            std::atomic_ref<uint32_t>(record(position)->state).store(Committed, std::memory_order_release);
+            std::atomic_ref<uint32_t>(header()->data_seq).fetch_add(1, std::memory_order_release);
+            futex_wake(&header()->data_seq);
+        }
+
+        // Copy one title into the ring; false if the ring stayed full for timeout_ms
+        template <typename Terms>
+        bool push_title(std::string_view name, const Terms& terms, const int& timeout_ms = -1) {
+            uint32_t length = static_cast<uint32_t>(title_record_bytes(name, terms));
+            uint64_t position = claim(Title, length, timeout_ms);
+            if (position == UINT64_MAX) return false;
+            pack_title(reinterpret_cast<char*>(record(position) + 1), name, terms);
+            publish(position);
+            return true;
+        }
+
+        // Tell the consumer this producer is done
+        void push_end() {
+            publish(claim(End, record_alignment));
+        }
+
+    private:
+        void* base = nullptr;
+        size_t mapped_bytes = 0;
+
+        static Ring map(const int& fd, const size_t& bytes, const std::string& name) {
+            void* address = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (address == MAP_FAILED) throw std::runtime_error("Could not map shared memory " + name + ": " + std::strerror(errno));
+            Ring ring;
+            ring.base = address;
+            ring.mapped_bytes = bytes;
+            return ring;
+        }
+
+        void lock() {
+            // The previous owner died inside claim(); header and tail are always left consistent
+            if (pthread_mutex_lock(&header()->claim_mutex) == EOWNERDEAD) pthread_mutex_consistent(&header()->claim_mutex);
+        }
+    };
+
+    volatile std::sig_atomic_t stop_requested = false;
+
+    void request_stop(int) {
+        stop_requested = true;
+    }
+
+    // Counters of a consume() run
+    struct ConsumeStats {
+        size_t titles = 0;
+        size_t terms = 0;
+        size_t skipped = 0;  // Records of producers that died before publishing them
+        size_t commits = 0;
+    };
+
+    /**
+     * @brief Consume records until expected_producers have sent End, or a stop is requested
+     *
+     * on_title is called for every title; on_commit is called before space is released, at most
+     * every commit_records titles and whenever the ring runs empty, so the caller can make the
+     * titles seen so far durable.
+     */
+    ConsumeStats consume(Ring& ring,
+                         const uint32_t& expected_producers,
+                         const std::function<void(const TitleView&)>& on_title,
+                         const std::function<void()>& on_commit) {
+        RingHeader* h = ring.header();
+        ConsumeStats stats;
+        TitleView title;
+        uint64_t cursor = std::atomic_ref<uint64_t>(h->head).load(std::memory_order_acquire);
+        uint32_t ended = std::atomic_ref<uint32_t>(h->ended_producers).load(std::memory_order_acquire);
+        size_t pending = 0;
+
+        auto release = [&]() {
+            if (cursor == std::atomic_ref<uint64_t>(h->head).load(std::memory_order_relaxed)) return;
+            on_commit();
+            ++stats.commits;
+            // Clear the states so the next lap never mistakes stale headers for published records
+            for (uint64_t position = std::atomic_ref<uint64_t>(h->head).load(std::memory_order_relaxed); position < cursor;) {
+                RecordHeader* r = ring.record(position);
+                position += r->length;
+                std::atomic_ref<uint32_t>(r->state).store(Empty, std::memory_order_relaxed);
+            }
+            std::atomic_ref<uint32_t>(h->ended_producers).store(ended, std::memory_order_relaxed);
+            std::atomic_ref<uint64_t>(h->head).store(cursor, std::memory_order_release);
+            std::atomic_ref<uint32_t>(h->space_seq).fetch_add(1, std::memory_order_release);
+            futex_wake(&h->space_seq);
+            pending = 0;
+        };
+
+        while (!stop_requested) {
+            uint32_t seq = std::atomic_ref<uint32_t>(h->data_seq).load(std::memory_order_acquire);
+            if (cursor == std::atomic_ref<uint64_t>(h->tail).load(std::memory_order_acquire)) {
+                release();
+                if (ended >= expected_producers) break;
+                futex_wait(&h->data_seq, seq, wait_timeout_ms);
+                continue;
+            }
+            RecordHeader* r = ring.record(cursor);
+            uint32_t state = std::atomic_ref<uint32_t>(r->state).load(std::memory_order_acquire);
+            if (state != Committed) {
+                if (!process_alive(r->pid)) {
+                    ++stats.skipped;
+                    cursor += r->length;
+                    continue;
+                }
+                futex_wait(&h->data_seq, seq, wait_timeout_ms);
+                continue;
+            }
+            if (r->type == Title) {
+                unpack_title(reinterpret_cast<const char*>(r + 1), title);
+                on_title(title);
+                ++stats.titles;
+                stats.terms += title.terms.size();
+                ++pending;
+            } else if (r->type == End) {
+                ++ended;
+            }
+            cursor += r->length;
+            if (pending >= commit_records) release();
+        }
+        release();
+        return stats;
+    }
+
+    /**
+     * @brief Ingest titles pushed by producer processes into file_token and relation_distance
+     *
+     * Runs until expected_producers have finished or SIGINT/SIGTERM. Producers attach to the ring by
+     * name, through Ring::attach or the study_ring_* functions of the shared library.
+     */
+    void ingest(const std::string& name, const uint64_t& capacity, const uint32_t& expected_producers, const bool& reset_table = true) {
+        try {
+            Ring ring = Ring::create(name, capacity);
+            sqlite3* db;
+            if (sqlite3_open(ENV_HPP::database_path.string().c_str(), &db) != SQLITE_OK) {
+                std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+                sqlite3_close(db);
+                throw std::runtime_error(message);
+            }
+            ConsumeStats stats;
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            try {
+                FEATURE::execute_sql(db, "PRAGMA synchronous = OFF;");
+                if (reset_table && ring.header()->head == 0) FEATURE::create_relational_tables(db);
+                std::cout << "Waiting for " << expected_producers << " producers on " << name << std::endl;
+                stop_requested = false;
+                std::signal(SIGINT, request_stop);
+                std::signal(SIGTERM, request_stop);
+                FEATURE::execute_sql(db, "BEGIN TRANSACTION;");
+                std::vector<std::pair<std::string_view, int>> terms;
+                stats = consume(ring, expected_producers,
+                    [&](const TitleView& title) {
+                        TRACE::Span title_span("ring.title", title.name);
+                        // Views into the record; the terms are bound straight from shared memory
+                        terms.assign(title.terms.begin(), title.terms.end());
+                        FEATURE::ingest_token_views(db, title.name, terms);
+                    },
+                    [&]() {
+                        METRICS::ScopedTimer commit_timer("ring.commit");
+                        FEATURE::execute_sql(db, "COMMIT TRANSACTION;");
+                        FEATURE::execute_sql(db, "BEGIN TRANSACTION;");
+                    });
+                FEATURE::bump_generation(db);
+                FEATURE::execute_sql(db, "COMMIT TRANSACTION;");
+                FEATURE::execute_sql(db, "PRAGMA synchronous = FULL;");
+            } catch (...) {
+                sqlite3_close(db);
+                throw;
+            }
+            sqlite3_close(db);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (!stop_requested) Ring::unlink(name);
+            std::cout << "Ingested " << stats.titles << " titles (" << stats.terms << " terms) in " << stats.commits
+                      << " commits, " << elapsed.count() << " seconds; skipped " << stats.skipped << " records of dead producers" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * @brief Compare handing token maps over the ring with the JSON file path
+     *
+     * A forked producer process pushes the token files' maps, repeated to num_titles titles, and the
+     * consumer takes views of each title's terms as the ingest does. The JSON path writes every map as a file and
+     * parses it back with TRANSFORMER::json_to_map, as computeRelationalDistance does.
+     */
+    void benchmarkRing(const size_t& num_titles, const uint64_t& capacity = 1 << 22) {
+        try {
+            std::vector<std::map<std::string, int>> maps;
+            for (const std::filesystem::path& file : UTILITIES_HPP::Basic::extract_data_files(ENV_HPP::json_path, false, ".json")) {
+                maps.push_back(TRANSFORMER::json_to_map(file));
+            }
+            if (maps.empty()) throw std::runtime_error("No token files in " + ENV_HPP::json_path.string());
+            const std::string name = "/study_ring_benchmark_" + std::to_string(::getpid());
+
+            // Shared memory ring
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            Ring ring = Ring::create(name, capacity);
+            pid_t child = ::fork();
+            if (child == 0) {
+                Ring producer = Ring::attach(name);
+                for (size_t t = 0; t < num_titles; ++t) producer.push_title("title_" + std::to_string(t), maps[t % maps.size()]);
+                producer.push_end();
+                ::_exit(0);
+            }
+            size_t ring_terms = 0;
+            std::vector<std::pair<std::string_view, int>> terms;
+            ConsumeStats stats = consume(ring, 1,
+                [&](const TitleView& title) {
+                    terms.assign(title.terms.begin(), title.terms.end());
+                    ring_terms += terms.size();
+                },
+                []() {});
+            ::waitpid(child, nullptr, 0);
+            Ring::unlink(name);
+            std::chrono::duration<double> ring_seconds = std::chrono::steady_clock::now() - start;
+
+            // JSON files
+            const std::filesystem::path folder = ENV_HPP::processed_data_path / ("ring_benchmark_" + std::to_string(::getpid()));
+            std::filesystem::create_directories(folder);
+            start = std::chrono::steady_clock::now();
+            child = ::fork();
+            if (child == 0) {
+                for (size_t t = 0; t < num_titles; ++t) {
+                    std::ofstream out(folder / ("title_" + std::to_string(t) + ".json"));
+                    out << json(maps[t % maps.size()]).dump(4);
+                }
+                ::_exit(0);
+            }
+            ::waitpid(child, nullptr, 0);
+            size_t json_terms = 0;
+            for (size_t t = 0; t < num_titles; ++t) {
+                json_terms += TRANSFORMER::json_to_map(folder / ("title_" + std::to_string(t) + ".json")).size();
+            }
+            std::chrono::duration<double> json_seconds = std::chrono::steady_clock::now() - start;
+            std::filesystem::remove_all(folder);
+
+            std::cout << "Titles: " << stats.titles << " over the ring, " << num_titles << " over JSON files" << std::endl
+                      << "Shared memory ring: " << ring_seconds.count() << " s, " << stats.titles / ring_seconds.count() << " titles/s" << std::endl
+                      << "JSON files:         " << json_seconds.count() << " s, " << num_titles / json_seconds.count() << " titles/s" << std::endl
+                      << "Terms " << (ring_terms == json_terms ? "match" : "DIFFER") << " (" << ring_terms << ")" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+#else
+    void ingest(const std::string&, const uint64_t&, const uint32_t&, const bool& = true) {
+        std::cerr << "Error: shared memory ingest requires Linux" << std::endl;
+    }
+
+    void benchmarkRing(const size_t&, const uint64_t& = 1 << 22) {
+        std::cerr << "Error: shared memory ingest requires Linux" << std::endl;
+    }
+#endif
+}
+
+#endif // SHMRING_HPP
@@ -0,0 +1,171 @@
+#ifndef SKETCH_HPP
+#define SKETCH_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+namespace SKETCH {
+
+    // 64-bit FNV-1a of the term, finished with a splitmix64 round so seeds give independent rows
+    uint64_t hash(std::string_view term, const uint64_t& seed) {
+        uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+        for (char c : term) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        h += 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    /**
+     * @brief Count-min sketch: depth rows of width counters, a term adds to one counter per row
+     *
+     * An estimate is the smallest of the term's counters. It never underestimates, and with
+     * probability at least 1 - delta it overestimates by at most epsilon * total, where
+     * epsilon = e / width and delta = exp(-depth).
+     */
+    class CountMinSketch {
+    public:
+        CountMinSketch(size_t width = 1, size_t depth = 1)
+            : width(std::max<size_t>(1, width)), depth(std::max<size_t>(1, depth)), counters(this->width * this->depth, 0) {}
+
+        void add(std::string_view term, const int64_t& count = 1) {
+            for (size_t row = 0; row < depth; ++row) counters[row * width + hash(term, row) % width] += count;
+            total += count;
+        }
+
+        int64_t estimate(std::string_view term) const {
+            int64_t result = std::numeric_limits<int64_t>::max();
+            for (size_t row = 0; row < depth; ++row) result = std::min(result, counters[row * width + hash(term, row) % width]);
+            return result;
+        }
+
+        double epsilon() const { return std::exp(1.0) / static_cast<double>(width); }
+        double delta() const { return std::exp(-static_cast<double>(depth)); }
+        int64_t error_bound() const { return static_cast<int64_t>(std::ceil(epsilon() * static_cast<double>(total))); }
+        int64_t total_count() const { return total; }
+        size_t bytes() const { return counters.size() * sizeof(int64_t); }
+
+    private:
+        size_t width;
+        size_t depth;
+        std::vector<int64_t> counters;
+        int64_t total = 0;
+    };
+
+    /**
+     * @brief Space-saving heavy hitters: the capacity most frequent terms of a weighted stream
+     *
+     * When a new term arrives and the table is full, it replaces the term with the smallest count
+     * and inherits that count as its error. Every term whose true count exceeds total / capacity is
+     * guaranteed to be kept, and a kept count overestimates the true count by at most its error.
+     */
+    class SpaceSaving {
+    public:
+        struct Counter {
+            int64_t count = 0;
+            int64_t error = 0;
+        };
+
+        explicit SpaceSaving(size_t capacity = 1) : capacity(std::max<size_t>(1, capacity)) {}
+
+        void add(const std::string& term, const int64_t& count = 1) {
+            total += count;
+            auto it = counters.find(term);
+            if (it != counters.end()) {
+                by_count.erase({it->second.count, term});
+                it->second.count += count;
+                by_count.insert({it->second.count, term});
+                return;
+            }
+            Counter counter = {.count = count, .error = 0};
+            if (counters.size() == capacity) {
+                auto smallest = by_count.begin();
+                counter = {.count = smallest->first + count, .error = smallest->first};
+                counters.erase(smallest->second);
+                by_count.erase(smallest);
+            }
+            counters.emplace(term, counter);
+            by_count.insert({counter.count, term});
+        }
+
+        // Kept terms with their counters, most frequent first
+        std::vector<std::pair<std::string, Counter>> top() const {
+            std::vector<std::pair<std::string, Counter>> result;
+            result.reserve(counters.size());
+            for (auto it = by_count.rbegin(); it != by_count.rend(); ++it) result.push_back({it->second, counters.at(it->second)});
+            return result;
+        }
+
+        // Any term with a larger true count is guaranteed to be kept
+        int64_t guarantee() const { return total / static_cast<int64_t>(capacity); }
+        size_t size() const { return counters.size(); }
+
+    private:
+        size_t capacity;
+        int64_t total = 0;
+        std::unordered_map<std::string, Counter> counters;
+        std::set<std::pair<int64_t, std::string>> by_count;
+    };
+
+    /**
+     * @brief Streaming global term statistics within a fixed memory budget
+     *
+     * A third of the budget goes to a count-min sketch of term counts, a third to one of document
+     * frequencies, and a third to the heavy hitters that name the terms to report.
+     */
+    struct TermSketch {
+        CountMinSketch counts;
+        CountMinSketch documents;
+        SpaceSaving heavy;
+
+        // Approximate memory per space-saving entry: two map nodes holding the term and counters
+        static constexpr size_t entry_bytes = 160;
+        static constexpr size_t depth = 4;
+
+        static TermSketch from_budget(const size_t& budget_bytes) {
+            const size_t part = budget_bytes / 3;
+            const size_t width = std::max<size_t>(1, part / (depth * sizeof(int64_t)));
+            return TermSketch{
+                .counts = CountMinSketch(width, depth),
+                .documents = CountMinSketch(width, depth),
+                .heavy = SpaceSaving(std::max<size_t>(1, part / entry_bytes)),
+            };
+        }
+
+        // Add the tokens of one title
+        template <typename Map>
+        void add_document(const Map& tokens) {
+            for (const auto& [term, count] : tokens) {
+                counts.add(term, count);
+                documents.add(term, 1);
+                heavy.add(term, count);
+            }
+        }
+
+        size_t bytes() const { return counts.bytes() + documents.bytes() + heavy.size() * entry_bytes; }
+    };
+
+    // Report the size and the error guarantees of a sketch
+    void print_bounds(const TermSketch& sketch) {
+        std::cout << "Sketch memory: " << sketch.bytes() << " bytes" << std::endl
+                  << "Count error: at most " << sketch.counts.error_bound() << " of " << sketch.counts.total_count()
+                  << " tokens (epsilon " << sketch.counts.epsilon() << ") with probability " << 1.0 - sketch.counts.delta() << std::endl
+                  << "Document frequency error: at most " << sketch.documents.error_bound() << " titles with probability "
+                  << 1.0 - sketch.documents.delta() << std::endl
+                  << "Heavy hitters: " << sketch.heavy.size() << " terms kept; every term counted more than "
+                  << sketch.heavy.guarantee() << " times is included" << std::endl;
+    }
+}
+
+#endif // SKETCH_HPP
@@ -0,0 +1,231 @@
+#ifndef SPARSE_HPP
+#define SPARSE_HPP
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "index.hpp"
+#include "parallel.hpp"
+
+namespace SPARSE {
+
+    /**
+     * @brief Compressed sparse row matrix of title vectors
+     *
+     * Row r holds the non-zero relational distances of document r of the title index;
+     * its entries are col_indices/values[row_offsets[r], row_offsets[r + 1]), with columns
+     * being term ids of the same index and sorted in ascending order.
+     */
+    struct CSRMatrix {
+        size_t rows = 0;
+        size_t cols = 0;
+        std::vector<uint32_t> row_offsets;
+        std::vector<int32_t> col_indices;
+        std::vector<double> values;
+
+        size_t nnz() const { return col_indices.size(); }
+    };
+
+    /**
+     * @brief Build the document-term CSR matrix by transposing the posting lists of a title index
+     *
+     * @param index The loaded title index
+     * @return The matrix with one row per document and one column per term
+     */
+    CSRMatrix build_csr(const INDEX::TitleIndex& index) {
+        CSRMatrix matrix;
+        matrix.rows = index.num_docs();
+        matrix.cols = index.num_terms();
+        matrix.row_offsets.assign(matrix.rows + 1, 0);
+
+        // Count the entries of each row, then turn the counts into offsets
+        for (const std::vector<INDEX::Posting>& list : index.postings) {
+            for (const INDEX::Posting& posting : list) {
+                matrix.row_offsets[posting.doc + 1]++;
+            }
+        }
+        for (size_t r = 0; r < matrix.rows; ++r) {
+            matrix.row_offsets[r + 1] += matrix.row_offsets[r];
+        }
+
+        matrix.col_indices.resize(matrix.row_offsets.back());
+        matrix.values.resize(matrix.row_offsets.back());
+        std::vector<uint32_t> cursor(matrix.row_offsets.begin(), matrix.row_offsets.end() - 1);
+
+        // Terms are visited in ascending id order, so every row ends up sorted by column
+        for (size_t term = 0; term < index.postings.size(); ++term) {
+            for (const INDEX::Posting& posting : index.postings[term]) {
+                uint32_t slot = cursor[posting.doc]++;
+                matrix.col_indices[slot] = static_cast<int32_t>(term);
+                matrix.values[slot] = posting.weight;
+            }
+        }
+        return matrix;
+    }
+
+    // y[r] = dot(row r, x) for every row in [row_begin, row_end), one entry at a time
+    void multiply_scalar(const CSRMatrix& matrix, const double* x, double* y, size_t row_begin, size_t row_end) {
+        for (size_t r = row_begin; r < row_end; ++r) {
+            double sum = 0.0;
+            for (uint32_t i = matrix.row_offsets[r]; i < matrix.row_offsets[r + 1]; ++i) {
+                sum += matrix.values[i] * x[matrix.col_indices[i]];
+            }
+            y[r] = sum;
+        }
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+    // y[r] = dot(row r, x), gathering four prompt weights at a time and accumulating with FMA
+    void multiply_avx2(const CSRMatrix& matrix, const double* x, double* y, size_t row_begin, size_t row_end) {
+        const int32_t* cols = matrix.col_indices.data();
+        const double* values = matrix.values.data();
+        for (size_t r = row_begin; r < row_end; ++r) {
+            uint32_t i = matrix.row_offsets[r];
+            const uint32_t end = matrix.row_offsets[r + 1];
+
+            __m256d acc = _mm256_setzero_pd();
+            for (; i + 4 <= end; i += 4) {
+                __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cols + i));
+                // All-ones mask: a plain gather, but with an explicit source GCC does not warn is uninitialized
+                __m256d gathered = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+                acc = _mm256_fmadd_pd(_mm256_loadu_pd(values + i), gathered, acc);
+            }
+
+            // Horizontal sum of the four lanes, then the remaining tail
+            __m128d low = _mm256_castpd256_pd128(acc);
+            __m128d high = _mm256_extractf128_pd(acc, 1);
+            low = _mm_add_pd(low, high);
+            double sum = _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+            for (; i < end; ++i) {
+                sum += values[i] * x[cols[i]];
+            }
+            y[r] = sum;
+        }
+    }
+#endif
+
+    // Name of the kernel selected at compile time
+    const char* kernel_name() {
+#if defined(__AVX2__) && defined(__FMA__)
+        return "avx2+fma";
+#else
+        return "scalar";
+#endif
+    }
+
+    /**
+     * @brief Split the rows into at most num_parts contiguous ranges holding similar numbers of non-zeros
+     *
+     * Splitting by non-zeros rather than by rows keeps threads balanced when title lengths are skewed.
+     *
+     * @return Range boundaries; range p is [bounds[p], bounds[p + 1])
+     */
+    std::vector<size_t> partition_rows(const CSRMatrix& matrix, const unsigned int& num_parts) {
+        unsigned int parts = std::max(1u, std::min<unsigned int>(num_parts, static_cast<unsigned int>(std::max<size_t>(1, matrix.rows))));
+        std::vector<size_t> bounds(parts + 1, matrix.rows);
+        bounds[0] = 0;
+        for (unsigned int p = 1; p < parts; ++p) {
+            uint64_t target = static_cast<uint64_t>(matrix.nnz()) * p / parts;
+            bounds[p] = std::lower_bound(matrix.row_offsets.begin(), matrix.row_offsets.end() - 1, target) - matrix.row_offsets.begin();
+        }
+        return bounds;
+    }
+
+    /**
+     * @brief Multiply the matrix by a dense vector, partitioning rows across threads
+     *
+     * @param matrix The document-term matrix
+     * @param x The dense vector, one entry per column
+     * @param num_threads The number of threads to use
+     * @return One dot product per row
+     */
+    std::vector<double> multiply(const CSRMatrix& matrix, const std::vector<double>& x,
+                                 const unsigned int& num_threads = PARALLEL::default_threads()) {
+        std::vector<double> y(matrix.rows, 0.0);
+        if (matrix.rows == 0) return y;
+
+        std::vector<size_t> bounds = partition_rows(matrix, num_threads);
+        unsigned int parts = static_cast<unsigned int>(bounds.size() - 1);
+        PARALLEL::parallel_for(parts, [&](size_t begin, size_t end, unsigned int) {
+            for (size_t p = begin; p < end; ++p) {
+#if defined(__AVX2__) && defined(__FMA__)
+                multiply_avx2(matrix, x.data(), y.data(), bounds[p], bounds[p + 1]);
+#else
+                multiply_scalar(matrix, x.data(), y.data(), bounds[p], bounds[p + 1]);
+#endif
+            }
+        }, parts);
+        return y;
+    }
+
+    // Build the dense prompt vector over the index vocabulary, using the weights of INDEX::prompt_weights
+    std::vector<double> dense_prompt_vector(const INDEX::TitleIndex& index, const std::map<std::string, int>& tokens) {
+        std::vector<double> x(index.num_terms(), 0.0);
+        for (const auto& [token, count, weight] : INDEX::prompt_weights(tokens)) {
+            int term = index.find_term(token);
+            if (term >= 0) x[term] = weight;
+        }
+        return x;
+    }
+
+    /**
+     * @brief Brute-force score every title with the CSR kernel
+     *
+     * Gives the same scores as INDEX::score_prompt up to floating point summation order,
+     * and serves as the reference for pruned evaluators.
+     */
+    std::vector<std::pair<int, double>> score_prompt(const CSRMatrix& matrix,
+                                                     const INDEX::TitleIndex& index,
+                                                     const std::map<std::string, int>& tokens,
+                                                     const int& top_n = 100,
+                                                     const unsigned int& num_threads = PARALLEL::default_threads()) {
+        return INDEX::top_k(multiply(matrix, dense_prompt_vector(index, tokens), num_threads), top_n);
+    }
+
+    /**
+     * @brief Process buffer.json with the brute-force CSR kernel
+     *
+     * Prints the top results, the build and scoring times, and the largest score deviation
+     * from the inverted index path so the kernel can be checked against it.
+     */
+    void processPrompt(const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            INDEX::TitleIndex index = INDEX::load_title_index();
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            CSRMatrix matrix = build_csr(index);
+            std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+
+            std::vector<double> x = dense_prompt_vector(index, tokens);
+            start = std::chrono::steady_clock::now();
+            std::vector<double> scores = multiply(matrix, x);
+            std::chrono::duration<double, std::micro> score_us = std::chrono::steady_clock::now() - start;
+
+            std::vector<std::pair<int, double>> reference = INDEX::score_prompt(index, tokens, static_cast<int>(index.num_docs()));
+            double max_deviation = 0.0;
+            for (const auto& [doc, score] : reference) {
+                max_deviation = std::max(max_deviation, std::abs(score - scores[doc]));
+            }
+
+            INDEX::print_results(index, INDEX::top_k(scores, top_n));
+            std::cout << "CSR matrix: " << matrix.rows << " rows, " << matrix.cols << " columns, " << matrix.nnz() << " non-zeros" << std::endl
+                      << "Kernel: " << kernel_name() << ", build " << build_ms.count() << " ms, score " << score_us.count() << " us" << std::endl
+                      << "Max deviation from inverted index scores: " << max_deviation << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // SPARSE_HPP
@@ -0,0 +1,344 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <sqlite3.h>
+#include <nlohmann/json.hpp>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "env.hpp"
+#include "utilities.hpp"
+#include "updateDB.hpp"
+#include "feature.hpp"
+#include "index.hpp"
+#include "bench.hpp"
+
+using json = nlohmann::json;
+
+namespace SYNTHETIC {
+
+    /**
+     * Shape of a synthetic corpus; token counts and chunk text are drawn from a Zipf distribution
+     * over BENCH::synthetic_term vocabulary.
+     */
+    struct CorpusSpec {
+        size_t titles = 1000;
+        size_t vocabulary = 50000;
+        double skew = 1.0;
+        size_t tokens_per_title = 1000;
+        size_t chunks_per_title = 4;   // On average; each title gets 1 to 2 * chunks_per_title - 1
+        size_t words_per_chunk = 32;
+        size_t prompt_tokens = 60;
+        uint64_t seed = 42;
+    };
+
+    // What generate_corpus() wrote
+    struct CorpusSummary {
+        size_t titles = 0;
+        size_t chunks = 0;
+        size_t tokens = 0;
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * @brief A one-page PDF showing the title, small but valid enough for PDF readers
+     */
+    std::string dummy_pdf(const std::string& title) {
+        std::string content = "BT /F1 24 Tf 72 720 Td (" + title + ") Tj ET";
+        std::vector<std::string> objects = {
+            "<< /Type /Catalog /Pages 2 0 R >>",
+            "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+            "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 4 0 R /Resources << /Font << /F1 5 0 R >> >> >>",
+            "<< /Length " + std::to_string(content.size()) + " >>\nstream\n" + content + "\nendstream",
+            "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+        };
+        std::string pdf = "%PDF-1.4\n";
+        std::vector<size_t> offsets;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            offsets.push_back(pdf.size());
+            pdf += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        size_t xref = pdf.size();
+        std::ostringstream table;
+        table << "xref\n0 " << objects.size() + 1 << "\n0000000000 65535 f \n";
+        for (size_t offset : offsets) table << std::setw(10) << std::setfill('0') << offset << " 00000 n \n";
+        table << "trailer\n<< /Size " << objects.size() + 1 << " /Root 1 0 R >>\nstartxref\n" << xref << "\n%%EOF\n";
+        return pdf + table.str();
+    }
+
+    /**
+     * @brief Write a complete synthetic data root
+     *
+     * root/resources holds one dummy PDF per title, root/pdf_text.db the pdf_chunks table, and
+     * root/token_json one token file per title, named after the file_info id that
+     * computeResourceData will derive for the PDF, as the Python tokenizer does. root/buffer.json
+     * holds a prompt drawn from the same distribution. Existing contents of root are replaced.
+     *
+     * @throws std::runtime_error if the database cannot be written.
+     */
+    CorpusSummary generate_corpus(const CorpusSpec& spec, const std::filesystem::path& root, const bool& show_progress = true) {
+        std::filesystem::remove_all(root);
+        const std::filesystem::path resources = root / ("resources");
+        const std::filesystem::path token_json = root / ("token_json");
+        std::filesystem::create_directories(resources);
+        std::filesystem::create_directories(token_json);
+        std::filesystem::create_directories(root / ("processed_data"));
+
+        sqlite3* db;
+        if (sqlite3_open((root / ("pdf_text.db")).string().c_str(), &db) != SQLITE_OK) {
+            std::string message = std::string("Error opening database: ") + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            throw std::runtime_error(message);
+        }
+        CorpusSummary summary;
+        try {
+            FEATURE::execute_sql(db, "PRAGMA synchronous = OFF;");
+            FEATURE::execute_sql(db, "CREATE TABLE pdf_chunks (id INTEGER PRIMARY KEY, file_name TEXT, chunk_index INTEGER, chunk_text TEXT);");
+            FEATURE::execute_sql(db, "BEGIN TRANSACTION;");
+            sqlite3_stmt* stmt;
+            sqlite3_prepare_v2(db, "INSERT INTO pdf_chunks (id, file_name, chunk_index, chunk_text) VALUES (?, ?, ?, ?);", -1, &stmt, nullptr);
+
+            BENCH::ZipfSampler sampler(spec.vocabulary, spec.skew);
+            std::vector<std::string> terms;
+            for (size_t k = 0; k < spec.vocabulary; ++k) terms.push_back(BENCH::synthetic_term(k));
+            std::mt19937_64 rng(spec.seed);
+            std::vector<size_t> ranks(spec.tokens_per_title);
+            int next_chunk_id = 1;
+            const size_t width = std::to_string(spec.titles).size();
+
+            for (size_t t = 0; t < spec.titles; ++t) {
+                std::ostringstream name;
+                name << "paper_" << std::setw(static_cast<int>(width)) << std::setfill('0') << t;
+                const std::filesystem::path pdf = resources / (name.str() + ".pdf");
+                const std::string content = dummy_pdf(name.str());
+                std::ofstream(pdf, std::ios::binary) << content;
+
+                // The title's text, of which the chunks are a prefix
+                std::map<std::string, int> counts;
+                for (size_t& rank : ranks) {
+                    rank = sampler(rng);
+                    ++counts[terms[rank]];
+                }
+
+                const std::string file_path = UTILITIES_HPP::Basic::convertToBackslash(pdf.generic_string());
+                const int chunk_count = static_cast<int>(1 + rng() % std::max<size_t>(1, 2 * spec.chunks_per_title - 1));
+                const int starting_id = next_chunk_id;
+                for (int c = 0; c < chunk_count; ++c) {
+                    std::string text;
+                    for (size_t w = 0; w < spec.words_per_chunk; ++w) {
+                        if (!text.empty()) text += ' ';
+                        text += terms[ranks[(c * spec.words_per_chunk + w) % ranks.size()]];
+                    }
+                    sqlite3_bind_int(stmt, 1, next_chunk_id++);
+                    sqlite3_bind_text(stmt, 2, file_path.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_int(stmt, 3, c);
+                    sqlite3_bind_text(stmt, 4, text.c_str(), -1, SQLITE_TRANSIENT);
+                    if (sqlite3_step(stmt) != SQLITE_DONE) {
+                        std::string message = std::string("Error inserting into pdf_chunks: ") + sqlite3_errmsg(db);
+                        sqlite3_finalize(stmt);
+                        throw std::runtime_error(message);
+                    }
+                    sqlite3_reset(stmt);
+                    summary.bytes += text.size();
+                }
+
+                const std::string id = UPDATE_INFO::create_unique_id(file_path, UPDATE_INFO::get_epoch_time(pdf), chunk_count, starting_id);
+                const std::string tokens = json(counts).dump(4);
+                std::ofstream(token_json / ("title_" + id + ".json")) << tokens;
+
+                summary.titles += 1;
+                summary.chunks += static_cast<size_t>(chunk_count);
+                summary.tokens += spec.tokens_per_title;
+                summary.bytes += content.size() + tokens.size();
+                if (show_progress && spec.titles >= 10 && (t + 1) % (spec.titles / 10) == 0) {
+                    std::cout << "Generated " << t + 1 << " of " << spec.titles << " titles" << std::endl;
+                }
+            }
+            sqlite3_finalize(stmt);
+            FEATURE::execute_sql(db, "COMMIT TRANSACTION;");
+            FEATURE::execute_sql(db, "PRAGMA synchronous = FULL;");
+
+            std::map<std::string, int> prompt;
+            for (size_t i = 0; i < spec.prompt_tokens; ++i) ++prompt[terms[sampler(rng)]];
+            std::ofstream(root / ("buffer.json")) << json(prompt).dump(4);
+        } catch (...) {
+            sqlite3_close(db);
+            throw;
+        }
+        sqlite3_close(db);
+        return summary;
+    }
+
+    // Discards everything written to it
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    // Silence std::cout for the lifetime of the object; errors still reach std::cerr
+    class QuietOutput {
+    public:
+        QuietOutput() : saved(std::cout.rdbuf(&sink)) {}
+        QuietOutput(const QuietOutput&) = delete;
+        QuietOutput& operator=(const QuietOutput&) = delete;
+        ~QuietOutput() { std::cout.rdbuf(saved); }
+
+    private:
+        NullBuffer sink;
+        std::streambuf* saved;
+    };
+
+    /**
+     * @brief Restart peak memory tracking, so peak_rss_bytes() covers only what follows
+     *
+     * Only Linux can reset the peak; elsewhere the peak is that of the whole process.
+     */
+    void reset_peak_rss() {
+#ifdef __linux__
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+    }
+
+    // Peak resident set size since the last reset_peak_rss(), or 0 if unknown
+    uint64_t peak_rss_bytes() {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) return std::stoull(line.substr(6)) * 1024;
+        }
+#endif
+#if defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#elif !defined(_WIN32)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#else
+        return 0;
+#endif
+    }
+
+    // One stage at one scale
+    struct StageResult {
+        std::string stage;
+        size_t titles;
+        double seconds;
+        uint64_t peak_rss;
+    };
+
+    StageResult run_stage(const std::string& stage, const size_t& titles, const std::function<void()>& fn) {
+        reset_peak_rss();
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        {
+            QuietOutput quiet;
+            fn();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return {stage, titles, elapsed.count(), peak_rss_bytes()};
+    }
+
+    /**
+     * @brief Generate a corpus of spec.titles titles under ENV_HPP::data_root / "synthetic"
+     */
+    void generateCorpus(const CorpusSpec& spec) {
+        try {
+            const std::filesystem::path root = ENV_HPP::data_root / ("synthetic");
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            CorpusSummary summary = generate_corpus(spec, root);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Wrote " << summary.titles << " titles, " << summary.chunks << " chunks and " << summary.tokens << " tokens ("
+                      << summary.bytes / 1e6 << " MB) to " << root << " in " << elapsed.count() << " seconds" << std::endl
+                      << "Run the pipeline on it with --dataroot " << root.generic_string() << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * @brief Run every pipeline stage on synthetic corpora of increasing size
+     *
+     * For each scale, a corpus is generated under processed_data/scaling_<titles> and the stages
+     * run against it in order: generate, updatedatabaseinformation, computerelationaldistance,
+     * computeglobalterms, processprompt, then loading the title index and scoring with it. Each
+     * stage is printed as it finishes, with throughput, peak memory and the scaling exponent: the
+     * slope of log(seconds) over log(titles) against the previous scale, 1 being linear. Results
+     * are also written to processed_data/scaling_benchmark.json. The corpora are removed afterwards.
+     */
+    void benchmarkScaling(const std::vector<size_t>& scales, CorpusSpec spec) {
+        const std::filesystem::path original_root = ENV_HPP::data_root;
+        const std::filesystem::path report_path = ENV_HPP::processed_data_path / ("scaling_benchmark.json");
+        json report = {{"vocabulary", spec.vocabulary}, {"skew", spec.skew}, {"tokens_per_title", spec.tokens_per_title}, {"stages", json::array()}};
+        std::map<std::string, StageResult> previous;
+
+        auto record = [&](const StageResult& result) {
+            auto last = previous.find(result.stage);
+            double exponent = (last != previous.end() && last->second.seconds > 0 && result.seconds > 0)
+                ? std::log(result.seconds / last->second.seconds) / std::log(static_cast<double>(result.titles) / last->second.titles)
+                : std::nan("");
+            std::cout << std::left << std::setw(28) << result.stage << std::right << std::setw(10) << result.titles
+                      << std::setw(12) << std::fixed << std::setprecision(3) << result.seconds
+                      << std::setw(14) << std::setprecision(0) << result.titles / std::max(result.seconds, 1e-9)
+                      << std::setw(12) << std::setprecision(1) << result.peak_rss / 1e6
+                      << std::setw(10) << std::setprecision(2) << exponent << std::defaultfloat << std::endl;
+            report["stages"].push_back({
+                {"stage", result.stage}, {"titles", result.titles}, {"seconds", result.seconds}, {"peak_rss_bytes", result.peak_rss},
+                {"exponent", std::isnan(exponent) ? json(nullptr) : json(exponent)},
+            });
+            previous.insert_or_assign(result.stage, result);
+        };
+
+        std::cout << std::left << std::setw(28) << "stage" << std::right << std::setw(10) << "titles" << std::setw(12) << "seconds"
+                  << std::setw(14) << "titles/s" << std::setw(12) << "peak MB" << std::setw(10) << "exponent" << std::endl;
+        try {
+            for (const size_t& titles : scales) {
+                spec.titles = titles;
+                const std::filesystem::path root = ENV_HPP::processed_data_path / ("scaling_" + std::to_string(titles));
+                record(run_stage("generate", titles, [&]() { generate_corpus(spec, root, false); }));
+
+                ENV_HPP::use_data_root(root);
+                const std::vector<std::filesystem::path> pdfs = UTILITIES_HPP::Basic::extract_data_files(root / ("resources"), false, ".pdf");
+                const std::vector<std::filesystem::path> token_files = UTILITIES_HPP::Basic::extract_data_files(ENV_HPP::json_path, false, ".json");
+                record(run_stage("updatedatabaseinformation", titles, [&]() { FEATURE::computeResourceData(pdfs, false, true, false); }));
+                record(run_stage("computerelationaldistance", titles, [&]() { FEATURE::computeRelationalDistance(token_files, false, true, false); }));
+                record(run_stage("computeglobalterms", titles, [&]() { FEATURE::computeGlobalTerms(token_files); }));
+                record(run_stage("processprompt", titles, [&]() { FEATURE::processPrompt(ENV_HPP::default_top_n); }));
+                INDEX::TitleIndex index;
+                record(run_stage("load_title_index", titles, [&]() { index = INDEX::load_title_index(); }));
+                std::map<std::string, int> prompt = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+                record(run_stage("score_prompt", titles, [&]() { BENCH::do_not_optimize(INDEX::score_prompt(index, prompt, ENV_HPP::default_top_n)); }));
+
+                ENV_HPP::use_data_root(original_root);
+                std::filesystem::remove_all(root);
+            }
+        } catch (const std::exception& e) {
+            ENV_HPP::use_data_root(original_root);
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+
+        std::ofstream out(report_path);
+        if (out) out << report.dump(4) << std::endl;
+        std::cout << "Scaling report written to " << report_path << std::endl;
+    }
+}
+
+#endif // SYNTHETIC_HPP
@@ -0,0 +1,259 @@
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <algorithm>
+
+namespace TOKENIZER {
+
+    // NLTK English stop words plus the banned words of word_freq.py
+    const std::unordered_set<std::string> stop_words = {
+        "i", "me", "my", "myself", "we", "our", "ours", "ourselves", "you", "you're", "you've", "you'll",
+        "you'd", "your", "yours", "yourself", "yourselves", "he", "him", "his", "himself", "she", "she's",
+        "her", "hers", "herself", "it", "it's", "its", "itself", "they", "them", "their", "theirs",
+        "themselves", "what", "which", "who", "whom", "this", "that", "that'll", "these", "those", "am",
+        "is", "are", "was", "were", "be", "been", "being", "have", "has", "had", "having", "do", "does",
+        "did", "doing", "a", "an", "the", "and", "but", "if", "or", "because", "as", "until", "while",
+        "of", "at", "by", "for", "with", "about", "against", "between", "into", "through", "during",
+        "before", "after", "above", "below", "to", "from", "up", "down", "in", "out", "on", "off", "over",
+        "under", "again", "further", "then", "once", "here", "there", "when", "where", "why", "how", "all",
+        "any", "both", "each", "few", "more", "most", "other", "some", "such", "no", "nor", "not", "only",
+        "own", "same", "so", "than", "too", "very", "s", "t", "can", "will", "just", "don", "don't",
+        "should", "should've", "now", "d", "ll", "m", "o", "re", "ve", "y", "ain", "aren", "aren't",
+        "couldn", "couldn't", "didn", "didn't", "doesn", "doesn't", "hadn", "hadn't", "hasn", "hasn't",
+        "haven", "haven't", "isn", "isn't", "ma", "mightn", "mightn't", "mustn", "mustn't", "needn",
+        "needn't", "shan", "shan't", "shouldn", "shouldn't", "wasn", "wasn't", "weren", "weren't", "won",
+        "won't", "wouldn", "wouldn't",
+        "enough", "get", "got", "far", "might", "ought", "must", "shall", "since", "also", "theirselves",
+        "could", "need", "done", "would", "may", "near", "gotten", "us"
+    };
+
+    /**
+     * @brief Porter stemmer
+     *
+     * Follows the original algorithm by M.F. Porter (1980). NLTK's default PorterStemmer adds a few
+     * extensions on top of it, so a small number of rare words stem differently from word_freq.py.
+     */
+    class PorterStemmer {
+    public:
+        std::string stem(const std::string& word) {
+            if (word.size() <= 2) return word;
+            b = word;
+            k = static_cast<int>(b.size()) - 1;
+            step1ab(); step1c(); step2(); step3(); step4(); step5();
+            return b.substr(0, k + 1);
+        }
+
+    private:
+        std::string b;
+        int k = 0;
+        int j = 0;
+
+        bool cons(int i) const {
+            switch (b[i]) {
+                case 'a': case 'e': case 'i': case 'o': case 'u': return false;
+                case 'y': return (i == 0) ? true : !cons(i - 1);
+                default: return true;
+            }
+        }
+
+        // Number of consonant-vowel sequences in b[0..j]
+        int m() const {
+            int n = 0, i = 0;
+            while (true) { if (i > j) return n; if (!cons(i)) break; i++; }
+            i++;
+            while (true) {
+                while (true) { if (i > j) return n; if (cons(i)) break; i++; }
+                i++; n++;
+                while (true) { if (i > j) return n; if (!cons(i)) break; i++; }
+                i++;
+            }
+        }
+
+        bool vowel_in_stem() const {
+            for (int i = 0; i <= j; i++) if (!cons(i)) return true;
+            return false;
+        }
+
+        bool doublec(int i) const {
+            return i >= 1 && b[i] == b[i - 1] && cons(i);
+        }
+
+        bool cvc(int i) const {
+            if (i < 2 || !cons(i) || cons(i - 1) || !cons(i - 2)) return false;
+            char ch = b[i];
+            return !(ch == 'w' || ch == 'x' || ch == 'y');
+        }
+
+        bool ends(const std::string& s) {
+            int length = static_cast<int>(s.size());
+            if (length > k + 1) return false;
+            if (b.compare(k - length + 1, length, s) != 0) return false;
+            j = k - length;
+            return true;
+        }
+
+        void setto(const std::string& s) {
+            b.replace(j + 1, k - j, s);
+            k = j + static_cast<int>(s.size());
+        }
+
+        void r(const std::string& s) { if (m() > 0) setto(s); }
+
+        void step1ab() {
+            if (b[k] == 's') {
+                if (ends("sses")) k -= 2;
+                else if (ends("ies")) setto("i");
+                else if (b[k - 1] != 's') k--;
+            }
+            if (ends("eed")) { if (m() > 0) k--; }
+            else if ((ends("ed") || ends("ing")) && vowel_in_stem()) {
+                k = j;
+                if (ends("at")) setto("ate");
+                else if (ends("bl")) setto("ble");
+                else if (ends("iz")) setto("ize");
+                else if (doublec(k)) {
+                    k--;
+                    char ch = b[k];
+                    if (ch == 'l' || ch == 's' || ch == 'z') k++;
+                }
+                else if (m() == 1 && cvc(k)) setto("e");
+            }
+        }
+
+        void step1c() {
+            if (ends("y") && vowel_in_stem()) b[k] = 'i';
+        }
+
+        void step2() {
+            if (k < 1) return;
+            switch (b[k - 1]) {
+                case 'a': if (ends("ational")) { r("ate"); break; } if (ends("tional")) { r("tion"); break; } break;
+                case 'c': if (ends("enci")) { r("ence"); break; } if (ends("anci")) { r("ance"); break; } break;
+                case 'e': if (ends("izer")) { r("ize"); break; } break;
+                case 'l': if (ends("bli")) { r("ble"); break; } if (ends("alli")) { r("al"); break; }
+                          if (ends("entli")) { r("ent"); break; } if (ends("eli")) { r("e"); break; }
+                          if (ends("ousli")) { r("ous"); break; } break;
+                case 'o': if (ends("ization")) { r("ize"); break; } if (ends("ation")) { r("ate"); break; }
+                          if (ends("ator")) { r("ate"); break; } break;
+                case 's': if (ends("alism")) { r("al"); break; } if (ends("iveness")) { r("ive"); break; }
+                          if (ends("fulness")) { r("ful"); break; } if (ends("ousness")) { r("ous"); break; } break;
+                case 't': if (ends("aliti")) { r("al"); break; } if (ends("iviti")) { r("ive"); break; }
+                          if (ends("biliti")) { r("ble"); break; } break;
+                case 'g': if (ends("logi")) { r("log"); break; } break;
+            }
+        }
+
+        void step3() {
+            switch (b[k]) {
+                case 'e': if (ends("icate")) { r("ic"); break; } if (ends("ative")) { r(""); break; }
+                          if (ends("alize")) { r("al"); break; } break;
+                case 'i': if (ends("iciti")) { r("ic"); break; } break;
+                case 'l': if (ends("ical")) { r("ic"); break; } if (ends("ful")) { r(""); break; } break;
+                case 's': if (ends("ness")) { r(""); break; } break;
+            }
+        }
+
+        void step4() {
+            if (k < 1) return;
+            switch (b[k - 1]) {
+                case 'a': if (ends("al")) break; return;
+                case 'c': if (ends("ance")) break; if (ends("ence")) break; return;
+                case 'e': if (ends("er")) break; return;
+                case 'i': if (ends("ic")) break; return;
+                case 'l': if (ends("able")) break; if (ends("ible")) break; return;
+                case 'n': if (ends("ant")) break; if (ends("ement")) break; if (ends("ment")) break; if (ends("ent")) break; return;
+                case 'o': if (ends("ion") && j >= 0 && (b[j] == 's' || b[j] == 't')) break; if (ends("ou")) break; return;
+                case 's': if (ends("ism")) break; return;
+                case 't': if (ends("ate")) break; if (ends("iti")) break; return;
+                case 'u': if (ends("ous")) break; return;
+                case 'v': if (ends("ive")) break; return;
+                case 'z': if (ends("ize")) break; return;
+                default: return;
+            }
+            if (m() > 1) k = j;
+        }
+
+        void step5() {
+            j = k;
+            if (b[k] == 'e') {
+                int a = m();
+                if (a > 1 || (a == 1 && !cvc(k - 1))) k--;
+            }
+            if (b[k] == 'l' && doublec(k) && m() > 1) k--;
+        }
+    };
+
+    // True if the word contains the same letter three or more times in a row
+    bool has_repeats(const std::string& word) {
+        for (size_t i = 2; i < word.size(); ++i) {
+            if (word[i] == word[i - 1] && word[i] == word[i - 2]) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Split text into cleaned, stemmed tokens in reading order
+     *
+     * Mirrors word_freq.clean_text: punctuation is removed, text is lowercased and split on whitespace,
+     * and only alphabetic tokens that are not stop words and have no tripled letters are stemmed and kept.
+     * Like clean_text, the first token and the last two tokens are dropped, since chunk boundaries
+     * usually cut through words there; queries are tokenized with trim_edges set to false.
+     *
+     * @param text The raw text
+     * @param trim_edges If true, drop the first token and the last two tokens
+     * @return The stemmed tokens in order of appearance
+     */
+    std::vector<std::string> tokenize(const std::string& text, const bool& trim_edges = true) {
+        std::vector<std::string> words;
+        std::string current;
+        bool alphabetic = true;
+        auto flush = [&]() {
+            if (!current.empty()) {
+                words.push_back(alphabetic ? current : std::string());
+            }
+            current.clear();
+            alphabetic = true;
+        };
+        for (char c : text) {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (std::isspace(u)) {
+                flush();
+            } else if (std::isalpha(u)) {
+                current.push_back(static_cast<char>(std::tolower(u)));
+            } else if (std::isdigit(u) || c == '_' || u >= 0x80) {
+                // Word characters that are not letters make the token non-alphabetic
+                current.push_back(c);
+                alphabetic = false;
+            }
+            // Punctuation is removed without splitting the word, as re.sub(r'[^\w\s]', '') does
+        }
+        flush();
+
+        std::vector<std::string> tokens;
+        if (trim_edges && words.size() < 4) return tokens;
+        PorterStemmer stemmer;
+        const size_t first = trim_edges ? 1 : 0;
+        const size_t last = trim_edges ? words.size() - 2 : words.size();
+        for (size_t i = first; i < last; ++i) {
+            const std::string& word = words[i];
+            if (word.empty() || stop_words.count(word) || has_repeats(word)) continue;
+            tokens.push_back(stemmer.stem(word));
+        }
+        return tokens;
+    }
+
+    // Count the stemmed tokens of a text, as clean_text does
+    std::map<std::string, int> count_tokens(const std::string& text) {
+        std::map<std::string, int> counts;
+        for (const std::string& token : tokenize(text)) {
+            counts[token]++;
+        }
+        return counts;
+    }
+}
+
+#endif // TOKENIZER_HPP
@@ -0,0 +1,147 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace TRACE {
+
+    /**
+     * Begin/end spans written as Chrome trace-event JSON, viewable in Perfetto or chrome://tracing.
+     *
+     * Every thread appends to its own buffer, so recording takes no lock; buffers are only read by
+     * write(), once the worker threads have been joined. enabled is set once by start() before any
+     * work starts; while it is false a span costs one predictable branch.
+     */
+
+    bool enabled = false;
+
+    // A complete span; name is a string literal, detail e.g. the file being processed
+    struct Event {
+        std::string_view name;
+        std::string detail;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+    };
+
+    struct Buffer {
+        uint32_t tid;
+        std::deque<Event> events; // Grows without moving recorded events
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        std::chrono::time_point<std::chrono::steady_clock> origin = std::chrono::steady_clock::now();
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    // Nanoseconds since the trace origin
+    uint64_t since_origin(const std::chrono::time_point<std::chrono::steady_clock>& time) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - registry().origin).count());
+    }
+
+    // The calling thread's buffer, registered on first use
+    Buffer& local_buffer() {
+        thread_local std::shared_ptr<Buffer> buffer = []() {
+            std::shared_ptr<Buffer> created = std::make_shared<Buffer>();
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            created->tid = static_cast<uint32_t>(registry().buffers.size());
+            registry().buffers.push_back(created);
+            return created;
+        }();
+        return *buffer;
+    }
+
+    // Enable tracing; call from the main thread, which becomes tid 0, before starting any work
+    void start() {
+        local_buffer();
+        enabled = true;
+    }
+
+    // Record a span measured by the caller; only call when enabled
+    void complete(std::string_view name,
+                  const std::chrono::time_point<std::chrono::steady_clock>& begin,
+                  const std::chrono::time_point<std::chrono::steady_clock>& end,
+                  std::string_view detail = {}) {
+        local_buffer().events.push_back({name, std::string(detail), since_origin(begin), since_origin(end)});
+    }
+
+    /**
+     * @brief Records a span from construction to destruction when tracing is enabled
+     */
+    class Span {
+    public:
+        explicit Span(std::string_view name, std::string_view detail = {}) {
+            if (enabled) [[unlikely]] {
+                event = &local_buffer().events.emplace_back(Event{name, std::string(detail), since_origin(std::chrono::steady_clock::now()), 0});
+            }
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+        ~Span() {
+            if (event) [[unlikely]] event->end_ns = since_origin(std::chrono::steady_clock::now());
+        }
+
+    private:
+        Event* event = nullptr;
+    };
+
+    /**
+     * @brief Serialize every thread's spans as trace-event JSON to output_path
+     *
+     * Spans become complete ("X") events with microsecond timestamps; each thread is named
+     * "main" or "worker <tid>".
+     */
+    void write(const std::filesystem::path& output_path) {
+        try {
+            json events = json::array();
+            size_t num_events = 0;
+            {
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                for (const std::shared_ptr<Buffer>& buffer : registry().buffers) {
+                    events.push_back({
+                        {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buffer->tid},
+                        {"args", {{"name", buffer->tid == 0 ? std::string("main") : "worker " + std::to_string(buffer->tid)}}},
+                    });
+                    for (const Event& event : buffer->events) {
+                        json entry = {
+                            {"name", event.name}, {"cat", "study"}, {"ph", "X"}, {"pid", 1}, {"tid", buffer->tid},
+                            {"ts", event.begin_ns / 1e3}, {"dur", (std::max(event.end_ns, event.begin_ns) - event.begin_ns) / 1e3},
+                        };
+                        if (!event.detail.empty()) entry["args"] = {{"detail", event.detail}};
+                        events.push_back(std::move(entry));
+                        ++num_events;
+                    }
+                }
+            }
+            if (output_path.has_parent_path()) std::filesystem::create_directories(output_path.parent_path());
+            std::ofstream out(output_path);
+            if (!out) throw std::runtime_error("Could not open " + output_path.string());
+            out << json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump() << std::endl;
+            std::cout << "Trace of " << num_events << " spans written to " << output_path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // TRACE_HPP
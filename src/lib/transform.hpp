@@ -14,8 +14,9 @@ using json = nlohmann::json;
 
 namespace TRANSFORMER {
 
-    // Compute the sum of all token frequencies in a given JSON object
-    int compute_sum_token_json(const std::map<std::string, int>& tokens) {
+    // Compute the sum of all token frequencies in a given JSON object, or any range of (token, frequency) pairs
+    template <typename Tokens = std::map<std::string, int>>
+    int compute_sum_token_json(const Tokens& tokens) {
         int result = 0;
         for (const auto& [key, value] : tokens) {
             result += value;
@@ -42,14 +43,23 @@ namespace TRANSFORMER {
         return result;
     }
 
-    // Count the number of unique tokens in a given JSON object
-    int count_unique_tokens(const std::map<std::string, int>& tokens) {
+    // Count the number of unique tokens in a given JSON object, or any range of (token, frequency) pairs
+    template <typename Tokens = std::map<std::string, int>>
+    int count_unique_tokens(const Tokens& tokens) {
         return tokens.size();
     }
 
+    // Convert a parsed JSON object of token frequencies into a map
+    std::map<std::string, int> json_object_to_map(const json& j) {
+        std::map<std::string, int> result;
+        for (auto it = j.begin(); it != j.end(); ++it) {
+            result[it.key()] = it.value().get<int>();
+        }
+        return result;
+    }
+
     // Parse a given JSON file and return the contents as a map
     std::map<std::string, int> json_to_map(const std::filesystem::path& json_file) {
-        std::map<std::string, int> result;
         std::ifstream file(json_file);
         if (!file.is_open()) {
             throw std::runtime_error("Could not open JSON file: " + json_file.string());
@@ -58,15 +68,12 @@ namespace TRANSFORMER {
         json j;
         file >> j;
 
-        for (auto it = j.begin(); it != j.end(); ++it) {
-            result[it.key()] = it.value().get<int>();
-        }
-
-        return result;
+        return json_object_to_map(j);
     }
 
-    // Compute the Euclidean norm of the given map of strings to integers
-    double Pythagoras(const std::map<std::string, int>& tokens) {
+    // Compute the Euclidean norm of the given map of strings to integers, or any range of (token, frequency) pairs
+    template <typename Tokens = std::map<std::string, int>>
+    double Pythagoras(const Tokens& tokens) {
         double result = 0.0;
         for (const auto& [key, value] : tokens) {
             result += value * value;
@@ -129,48 +129,6 @@ namespace UTILITIES_HPP {
             file << "ID, File Name, File Path, Epoch Time, Chunk Count, Starting ID, Ending ID" << std::endl;
         }
 
-        // Dump the contents of a DataEntry to a file
-        void data_entry_dump(const DataEntry& entry) {
-            std::ofstream main_file(ENV_HPP::data_dumper_path.string(), std::ios::app); // Append to file
-            if (!main_file.is_open()) {
-                std::cout << "Could not open main file" << std::endl;
-                return;
-            }
-            main_file << entry.path << ", " << entry.sum << ", " << entry.num_unique_tokens << ", " << entry.relational_distance << std::endl;
-
-            // Construct the path for the filtered file
-            std::ofstream filtered_file(ENV_HPP::filtered_data_path.string(), std::ios::app);// Append to file
-            if (!filtered_file.is_open()) {
-                std::cout << "Could not open filtered file" << std::endl;
-                return;
-            }
-
-            for (const std::tuple<std::string, int, double>& token : entry.filtered_tokens) {
-                filtered_file << entry.path << ", " 
-                              << std::get<0>(token) << ", " 
-                              << std::get<1>(token) << ", " 
-                              << std::get<2>(token)
-                              << std::endl;
-            }
-        }
-
-        // Dump the contents of a DataInfo to a file
-        void data_info_dump(const DataInfo& info) {
-            std::ofstream file(ENV_HPP::data_info_path.string(), std::ios::app | std::ios::binary);
-            if (!file.is_open()) {
-                std::cout << "Could not open file" << std::endl;
-                return;
-            }
-            file << info.id << ", "
-                 << info.file_name << ", "
-                 << info.file_path << ", "
-                 << info.epoch_time << ", "
-                 << info.chunk_count << ", "
-                 << info.starting_id << ", "
-                 << info.ending_id
-                 << std::endl;
-        }
-
         // Extract specific data from given directory with other instructions
         std::vector<std::filesystem::path> extract_data_files(const std::filesystem::path& target_folder, const bool& show_index, const std::string& extension) {
             std::vector<std::filesystem::path> collected_files = UTILITIES_HPP::Basic::list_directory(target_folder, show_index);
@@ -0,0 +1,343 @@
+#ifndef VOCAB_HPP
+#define VOCAB_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <tuple>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "env.hpp"
+#include "index.hpp"
+#include "codec.hpp"
+
+namespace VOCAB {
+
+    /**
+     * @brief Static trie over the vocabulary in flat arrays
+     *
+     * Nodes are numbered breadth first, so the outgoing edges of node n are the contiguous range
+     * [edge_begin[n], edge_begin[n + 1]) of labels/targets, sorted by label. A node that ends a term
+     * stores its term id in node_terms, otherwise -1. Shared prefixes are stored once, and a lookup
+     * touches only a few small arrays. min_lengths/max_lengths bound the lengths of the terms below
+     * each node, which lets fuzzy lookups drop subtrees whose terms are all too short or too long.
+     */
+    struct TermTrie {
+        std::vector<uint32_t> edge_begin;
+        std::vector<char> labels;
+        std::vector<uint32_t> targets;
+        std::vector<int32_t> node_terms;
+        std::vector<uint32_t> min_lengths;
+        std::vector<uint32_t> max_lengths;
+
+        size_t num_nodes() const { return node_terms.size(); }
+
+        // Child of node along label c, or -1
+        int64_t child(const uint32_t& node, const char& c) const {
+            auto first = labels.begin() + edge_begin[node];
+            auto last = labels.begin() + edge_begin[node + 1];
+            auto it = std::lower_bound(first, last, c);
+            return (it != last && *it == c) ? static_cast<int64_t>(targets[it - labels.begin()]) : -1;
+        }
+
+        size_t bytes() const {
+            return edge_begin.size() * sizeof(uint32_t) + labels.size() + targets.size() * sizeof(uint32_t)
+                 + node_terms.size() * sizeof(int32_t) + (min_lengths.size() + max_lengths.size()) * sizeof(uint32_t);
+        }
+    };
+
+    /**
+     * @brief Build the trie over the given terms
+     *
+     * @param terms The vocabulary; term ids are positions in this vector
+     */
+    TermTrie build_trie(const std::vector<std::string>& terms) {
+        std::vector<int32_t> order(terms.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int32_t>(i);
+        std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return terms[a] < terms[b]; });
+        order.erase(std::unique(order.begin(), order.end(), [&](int32_t a, int32_t b) { return terms[a] == terms[b]; }), order.end());
+
+        // Each queued node covers the sorted terms [lo, hi), which share their first depth characters
+        TermTrie trie;
+        std::deque<std::tuple<size_t, size_t, size_t>> queue = {{0, order.size(), 0}};
+        trie.node_terms.push_back(-1);
+        while (!queue.empty()) {
+            auto [lo, hi, depth] = queue.front();
+            queue.pop_front();
+            size_t node = trie.edge_begin.size();
+            trie.edge_begin.push_back(static_cast<uint32_t>(trie.labels.size()));
+            if (lo < hi && terms[order[lo]].size() == depth) {
+                trie.node_terms[node] = order[lo];
+                ++lo;
+            }
+            while (lo < hi) {
+                char c = terms[order[lo]][depth];
+                size_t end = lo;
+                while (end < hi && terms[order[end]][depth] == c) ++end;
+                trie.labels.push_back(c);
+                trie.targets.push_back(static_cast<uint32_t>(trie.node_terms.size()));
+                trie.node_terms.push_back(-1);
+                queue.push_back({lo, end, depth + 1});
+                lo = end;
+            }
+        }
+        trie.edge_begin.push_back(static_cast<uint32_t>(trie.labels.size()));
+
+        // Children are numbered after their parents, so one backward pass sees every subtree first
+        trie.min_lengths.assign(trie.num_nodes(), UINT32_MAX);
+        trie.max_lengths.assign(trie.num_nodes(), 0);
+        for (size_t node = trie.num_nodes(); node-- > 0;) {
+            if (trie.node_terms[node] >= 0) {
+                const uint32_t length = static_cast<uint32_t>(terms[trie.node_terms[node]].size());
+                trie.min_lengths[node] = std::min(trie.min_lengths[node], length);
+                trie.max_lengths[node] = std::max(trie.max_lengths[node], length);
+            }
+            for (uint32_t e = trie.edge_begin[node]; e < trie.edge_begin[node + 1]; ++e) {
+                trie.min_lengths[node] = std::min(trie.min_lengths[node], trie.min_lengths[trie.targets[e]]);
+                trie.max_lengths[node] = std::max(trie.max_lengths[node], trie.max_lengths[trie.targets[e]]);
+            }
+        }
+        return trie;
+    }
+
+    const uint32_t trie_magic = 0x45495254; // "TRIE"
+    const uint32_t trie_version = 1;
+
+    // Save the trie with the vocabulary it was built over, so a later load can check it still applies
+    void save_trie(const TermTrie& trie, const std::vector<std::string>& terms, const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not open vocabulary trie file: " + path.string());
+        }
+        CODEC::write_value(out, trie_magic);
+        CODEC::write_value(out, trie_version);
+        CODEC::write_strings(out, terms);
+        CODEC::write_vector(out, trie.edge_begin);
+        CODEC::write_vector(out, trie.labels);
+        CODEC::write_vector(out, trie.targets);
+        CODEC::write_vector(out, trie.node_terms);
+        CODEC::write_vector(out, trie.min_lengths);
+        CODEC::write_vector(out, trie.max_lengths);
+    }
+
+    /**
+     * @brief Load the trie saved for this vocabulary, or build and save it
+     *
+     * The saved trie is reused only if it was built over exactly the given terms in the same order,
+     * since its node_terms are positions in that vector.
+     */
+    TermTrie load_trie(const std::vector<std::string>& terms, const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (in.is_open() && CODEC::read_value<uint32_t>(in) == trie_magic && CODEC::read_value<uint32_t>(in) == trie_version
+            && CODEC::read_strings(in) == terms) {
+            TermTrie trie;
+            trie.edge_begin = CODEC::read_vector<uint32_t>(in);
+            trie.labels = CODEC::read_vector<char>(in);
+            trie.targets = CODEC::read_vector<uint32_t>(in);
+            trie.node_terms = CODEC::read_vector<int32_t>(in);
+            trie.min_lengths = CODEC::read_vector<uint32_t>(in);
+            trie.max_lengths = CODEC::read_vector<uint32_t>(in);
+            return trie;
+        }
+        in.close();
+        TermTrie trie = build_trie(terms);
+        save_trie(trie, terms, path);
+        return trie;
+    }
+
+    // Return the term id of an exact match, or -1
+    int32_t find(const TermTrie& trie, const std::string& word) {
+        int64_t node = 0;
+        for (char c : word) {
+            node = trie.child(static_cast<uint32_t>(node), c);
+            if (node < 0) return -1;
+        }
+        return trie.node_terms[node];
+    }
+
+    /**
+     * @brief Collect the terms that start with the given prefix
+     *
+     * @param limit The maximum number of terms to return, in lexicographic order
+     */
+    std::vector<int32_t> prefix_terms(const TermTrie& trie, const std::string& prefix, const size_t& limit = 64) {
+        std::vector<int32_t> result;
+        int64_t start = 0;
+        for (char c : prefix) {
+            start = trie.child(static_cast<uint32_t>(start), c);
+            if (start < 0) return result;
+        }
+        std::vector<uint32_t> stack = {static_cast<uint32_t>(start)};
+        while (!stack.empty() && result.size() < limit) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            if (trie.node_terms[node] >= 0) result.push_back(trie.node_terms[node]);
+            // Push children in reverse so the smallest label is visited first
+            for (uint32_t e = trie.edge_begin[node + 1]; e > trie.edge_begin[node]; --e) {
+                stack.push_back(trie.targets[e - 1]);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Find every term within max_distance Levenshtein edits of the word
+     *
+     * Walks the trie depth first while keeping one dynamic programming row per depth, which simulates
+     * a Levenshtein automaton over the trie. Only the band of cells within max_distance of the
+     * diagonal is computed, as cells outside it always exceed max_distance. A branch is abandoned
+     * once no cell can finish within max_distance: each cell's value plus the length difference
+     * still to cover, given the shortest and longest term below the node, must stay in range. Once
+     * every cell has used up the budget, the remaining word is followed directly instead.
+     *
+     * @return (term id, distance) pairs sorted by distance, then term id
+     */
+    std::vector<std::pair<int32_t, int>> fuzzy_terms(const TermTrie& trie, const std::string& word, const int& max_distance) {
+        std::vector<std::pair<int32_t, int>> result;
+        const int n = static_cast<int>(word.size());
+        const int width = n + 1;
+        const int out_of_band = max_distance + 1;
+        // rows[d] is the row of the node at depth d on the current path; cells outside the band hold out_of_band
+        std::vector<int> rows(width);
+        for (int i = 0; i < width; ++i) rows[i] = std::min(i, out_of_band);
+        if (trie.node_terms[0] >= 0 && rows[n] <= max_distance) result.push_back({trie.node_terms[0], rows[n]});
+
+        // Smallest final distance reachable from cell i of a row at the given depth of the given node
+        auto reachable = [&](const int* row, const int& depth, const uint32_t& node) {
+            int best = out_of_band;
+            const int shortest = static_cast<int>(trie.min_lengths[node]) - depth;
+            const int longest = static_cast<int>(trie.max_lengths[node]) - depth;
+            for (int i = std::max(0, depth - max_distance); i <= std::min(n, depth + max_distance); ++i) {
+                const int remaining = n - i;
+                const int gap = (remaining > longest) ? remaining - longest : (remaining < shortest) ? shortest - remaining : 0;
+                best = std::min(best, row[i] + gap);
+            }
+            return best;
+        };
+        if (reachable(rows.data(), 0, 0) > max_distance) return result;
+
+        // Stack of (node, depth of node, label leading to node)
+        std::vector<std::tuple<uint32_t, int, char>> stack;
+        for (uint32_t e = trie.edge_begin[1]; e > trie.edge_begin[0]; --e) stack.push_back({trie.targets[e - 1], 1, trie.labels[e - 1]});
+        while (!stack.empty()) {
+            auto [node, depth, c] = stack.back();
+            stack.pop_back();
+            if (static_cast<int>(rows.size()) < (depth + 1) * width) rows.resize(static_cast<size_t>(depth + 1) * width, out_of_band);
+            const int* previous = rows.data() + (depth - 1) * width;
+            int* row = rows.data() + depth * width;
+            const int first = std::max(1, depth - max_distance);
+            const int last = std::min(n, depth + max_distance);
+            row[0] = std::min(depth, out_of_band);
+            if (first > 1) row[first - 1] = out_of_band;
+            for (int i = first; i <= last; ++i) {
+                int cost = (word[i - 1] == c) ? 0 : 1;
+                row[i] = std::min({previous[i] + 1, row[i - 1] + 1, previous[i - 1] + cost, out_of_band});
+            }
+            if (last < n) row[last + 1] = out_of_band;
+            if (trie.node_terms[node] >= 0 && row[n] <= max_distance) {
+                result.push_back({trie.node_terms[node], row[n]});
+            }
+            if (reachable(row, depth, node) > max_distance) continue;
+            int best = out_of_band;
+            for (int i = std::max(0, depth - max_distance); i <= last; ++i) best = std::min(best, row[i]);
+            if (best < max_distance) {
+                for (uint32_t e = trie.edge_begin[node + 1]; e > trie.edge_begin[node]; --e) {
+                    stack.push_back({trie.targets[e - 1], depth + 1, trie.labels[e - 1]});
+                }
+                continue;
+            }
+            // At the edge of the budget a cell only stays in range by matching the rest of the word exactly,
+            // so each such cell follows word[i..n) straight down and ends on a distinct term at max_distance
+            for (int i = std::max(0, depth - max_distance); i < std::min(n, last + 1); ++i) {
+                const uint32_t length = static_cast<uint32_t>(depth + n - i);
+                if (row[i] != max_distance || length < trie.min_lengths[node] || length > trie.max_lengths[node]) continue;
+                int64_t next = node;
+                for (int j = i; j < n && next >= 0; ++j) next = trie.child(static_cast<uint32_t>(next), word[j]);
+                if (next >= 0 && trie.node_terms[next] >= 0) result.push_back({trie.node_terms[next], max_distance});
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+            return (a.second != b.second) ? a.second < b.second : a.first < b.first;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Replace prompt tokens that are not in the vocabulary by their nearest vocabulary terms
+     *
+     * An unknown token is expanded to the terms at the smallest Levenshtein distance up to
+     * max_distance; if there are none, to the terms it is a prefix of. At most max_expansions terms
+     * are kept, preferring terms found in more titles, and each inherits the token's count.
+     * Distances are searched from 1 upwards, so the wider and slower searches only run for tokens
+     * with no nearer term.
+     *
+     * @param expansions Filled with (token, term) pairs describing every expansion made
+     * @return The expanded token counts
+     */
+    std::map<std::string, int> expand_tokens(const TermTrie& trie,
+                                             const INDEX::TitleIndex& index,
+                                             const std::map<std::string, int>& tokens,
+                                             const int& max_distance,
+                                             const size_t& max_expansions,
+                                             std::vector<std::pair<std::string, std::string>>& expansions) {
+        std::map<std::string, int> expanded;
+        for (const auto& [token, count] : tokens) {
+            if (find(trie, token) >= 0) {
+                expanded[token] += count;
+                continue;
+            }
+            std::vector<int32_t> candidates;
+            for (int distance = 1; distance <= max_distance && candidates.empty(); ++distance) {
+                for (const auto& [term, found] : fuzzy_terms(trie, token, distance)) {
+                    if (found == distance) candidates.push_back(term);
+                }
+            }
+            if (candidates.empty()) candidates = prefix_terms(trie, token);
+
+            std::stable_sort(candidates.begin(), candidates.end(), [&](int32_t a, int32_t b) {
+                return index.postings[a].size() > index.postings[b].size();
+            });
+            if (candidates.size() > max_expansions) candidates.resize(max_expansions);
+            for (int32_t term : candidates) {
+                expanded[index.terms[term]] += count;
+                expansions.push_back({token, index.terms[term]});
+            }
+        }
+        return expanded;
+    }
+
+    // Process buffer.json, expanding unknown tokens before scoring, and report the expansions
+    void processPrompt(const int& max_distance, const size_t& max_expansions, const int& top_n = 100) {
+        try {
+            std::map<std::string, int> tokens = TRANSFORMER::json_to_map(ENV_HPP::buffer_json_path);
+            INDEX::TitleIndex index = INDEX::load_title_index();
+
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            TermTrie trie = load_trie(index.terms, ENV_HPP::vocab_trie_path);
+            std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - start;
+
+            std::vector<std::pair<std::string, std::string>> expansions;
+            start = std::chrono::steady_clock::now();
+            std::map<std::string, int> expanded = expand_tokens(trie, index, tokens, max_distance, max_expansions, expansions);
+            std::chrono::duration<double, std::micro> expand_us = std::chrono::steady_clock::now() - start;
+
+            INDEX::print_results(index, INDEX::score_prompt(index, expanded, top_n));
+            for (const auto& [token, term] : expansions) {
+                std::cout << "Expanded: " << token << " -> " << term << std::endl;
+            }
+            std::cout << "Vocabulary trie: " << index.num_terms() << " terms, " << trie.num_nodes() << " nodes, "
+                      << trie.bytes() << " bytes, loaded in " << build_ms.count() << " ms" << std::endl
+                      << "Expanded " << expansions.size() << " terms in " << expand_us.count() << " us" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+}
+
+#endif // VOCAB_HPP
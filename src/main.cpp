@@ -11,10 +11,29 @@
 #include "lib/feature.hpp"
 #include "lib/env.hpp"
 #include "lib/utilities.hpp"
+#include "lib/server.hpp"
+#include "lib/batch.hpp"
+#include "lib/sparse.hpp"
+#include "lib/cosine.hpp"
+#include "lib/chunk.hpp"
+#include "lib/rerank.hpp"
+#include "lib/impact.hpp"
+#include "lib/phrase.hpp"
+#include "lib/boolean.hpp"
+#include "lib/vocab.hpp"
+#include "lib/scoring.hpp"
+#include "lib/metadata.hpp"
+#include "lib/roaring.hpp"
+#include "lib/columnar.hpp"
+#include "lib/shmring.hpp"
+#include "lib/metrics.hpp"
+#include "lib/trace.hpp"
+#include "lib/synthetic.hpp"
 
 const bool reset_table = true;
 const bool show_progress = false;
 const bool is_dumped = false;
+const COSINE::Precision cosine_precision = COSINE::Precision::Int8;
 
 void displayHelp() {
     std::cout << "This program is created as an integrated part of the word tokenizer project\n"
@@ -32,6 +51,14 @@ void computeRelationalDistance() {
     std::cout << "Finished: Relational distance data computed." << std::endl;
 }
 
+void computeRelationalDistanceSketch() {
+    std::vector<std::filesystem::path> filtered_files = UTILITIES_HPP::Basic::extract_data_files(ENV_HPP::json_path, false, ".json");
+    std::cout << "Computing relational distance data with streaming term statistics..." << std::endl;
+    SKETCH::TermSketch sketch = SKETCH::TermSketch::from_budget(ENV_HPP::sketch_memory_budget);
+    FEATURE::computeRelationalDistance(filtered_files, show_progress, reset_table, is_dumped, &sketch);
+    std::cout << "Finished: Relational distance data computed." << std::endl;
+}
+
 void updateDatabaseInformation() {
     std::vector<std::filesystem::path> filtered_files = UTILITIES_HPP::Basic::extract_data_files(ENV_HPP::resource_path, false, ".pdf");
     std::cout << "Updating database information..." << std::endl;
@@ -39,12 +66,184 @@ void updateDatabaseInformation() {
     std::cout << "Finished: Database information updated." << std::endl;
 }
 
+void computeGlobalTerms() {
+    std::vector<std::filesystem::path> token_files = UTILITIES_HPP::Basic::extract_data_files(ENV_HPP::json_path, false, ".json");
+    std::cout << "Computing global term statistics..." << std::endl;
+    FEATURE::computeGlobalTerms(token_files, PARALLEL::default_threads(), reset_table);
+    std::cout << "Finished: Global term statistics computed." << std::endl;
+}
+
+void exportColumnar() {
+    std::cout << "Exporting columnar tables..." << std::endl;
+    COLUMNAR::exportColumnar(ENV_HPP::columnar_compression);
+    std::cout << "Finished: Columnar tables exported." << std::endl;
+}
+
+void benchmarkExport() {
+    std::cout << "Benchmarking columnar export..." << std::endl;
+    COLUMNAR::benchmarkExport(ENV_HPP::export_benchmark_replicas);
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
+void ingestRing() {
+    std::cout << "Ingesting token maps from shared memory..." << std::endl;
+    SHMRING::ingest(ENV_HPP::shm_ring_name, ENV_HPP::shm_ring_bytes, ENV_HPP::shm_ring_producers);
+    std::cout << "Finished: Shared memory ingest stopped." << std::endl;
+}
+
+void benchmarkRing() {
+    std::cout << "Benchmarking shared memory ring..." << std::endl;
+    SHMRING::benchmarkRing(ENV_HPP::ring_benchmark_titles);
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
+SYNTHETIC::CorpusSpec synthetic_spec() {
+    return {
+        .titles = ENV_HPP::synthetic_titles,
+        .vocabulary = ENV_HPP::synthetic_vocabulary,
+        .skew = ENV_HPP::synthetic_skew,
+        .tokens_per_title = ENV_HPP::synthetic_tokens_per_title,
+    };
+}
+
+void generateCorpus() {
+    std::cout << "Generating synthetic corpus..." << std::endl;
+    SYNTHETIC::generateCorpus(synthetic_spec());
+    std::cout << "Finished: Synthetic corpus generated." << std::endl;
+}
+
+void benchmarkScaling() {
+    std::cout << "Benchmarking pipeline scaling..." << std::endl;
+    SYNTHETIC::benchmarkScaling(ENV_HPP::scaling_benchmark_scales, synthetic_spec());
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
 void processPrompt() {
     std::cout << "Processing prompt..." << std::endl;
-    FEATURE::processPrompt(100);
+    FEATURE::processPrompt(ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptParallel() {
+    std::cout << "Processing prompt with parallel scoring..." << std::endl;
+    INDEX::processPrompt(ENV_HPP::default_top_n, PARALLEL::default_threads());
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptCSR() {
+    std::cout << "Processing prompt with the CSR kernel..." << std::endl;
+    SPARSE::processPrompt(ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptCosine() {
+    std::cout << "Processing prompt with cosine scoring..." << std::endl;
+    COSINE::processPrompt(cosine_precision, ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptBM25() {
+    std::cout << "Processing prompt with BM25 impacts..." << std::endl;
+    SCORING::processPrompt(SCORING::Model::BM25, COSINE::Precision::Float64, ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptTfIdf() {
+    std::cout << "Processing prompt with TF-IDF impacts..." << std::endl;
+    SCORING::processPrompt(SCORING::Model::TfIdf, COSINE::Precision::Float64, ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptBoolean() {
+    std::cout << "Processing prompt with boolean filter..." << std::endl;
+    BOOLEAN::processPrompt();
     std::cout << "Finished: Prompt processed." << std::endl;
 }
 
+void processPromptExpanded() {
+    std::cout << "Processing prompt with vocabulary expansion..." << std::endl;
+    VOCAB::processPrompt(ENV_HPP::fuzzy_distance, ENV_HPP::max_expansions, ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void benchmarkScoring() {
+    std::cout << "Benchmarking templated scoring..." << std::endl;
+    SCORING::benchmarkScoring();
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
+void processPromptFiltered() {
+    std::cout << "Processing prompt with metadata filter..." << std::endl;
+    METADATA::processPrompt();
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptFacets() {
+    std::cout << "Processing prompt with facets..." << std::endl;
+    ROARING::processPrompt();
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void benchmarkFacets() {
+    std::cout << "Benchmarking facet counts..." << std::endl;
+    ROARING::benchmarkFacets();
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
+void benchmarkIntersection() {
+    std::cout << "Benchmarking posting list intersection..." << std::endl;
+    BOOLEAN::benchmarkIntersection();
+    std::cout << "Finished: Benchmark complete." << std::endl;
+}
+
+void buildChunkIndex() {
+    std::cout << "Building chunk index..." << std::endl;
+    CHUNK::buildChunkIndex();
+    std::cout << "Finished: Chunk index built." << std::endl;
+}
+
+void buildImpactIndex() {
+    std::cout << "Building impact index..." << std::endl;
+    IMPACT::buildImpactIndex();
+    std::cout << "Finished: Impact index built." << std::endl;
+}
+
+void processPromptChunks() {
+    std::cout << "Processing prompt against chunks..." << std::endl;
+    CHUNK::processPrompt(ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void processPromptTwoStage() {
+    std::cout << "Processing prompt with two-stage retrieval..." << std::endl;
+    RERANK::processPrompt(ENV_HPP::candidate_depth, ENV_HPP::default_top_n);
+    std::cout << "Finished: Prompt processed." << std::endl;
+}
+
+void buildPositionalIndex() {
+    std::cout << "Building positional index..." << std::endl;
+    PHRASE::buildPositionalIndex();
+    std::cout << "Finished: Positional index built." << std::endl;
+}
+
+void processPhrases() {
+    std::cout << "Processing phrase queries..." << std::endl;
+    PHRASE::processPhrases(ENV_HPP::phrase_query_path, ENV_HPP::default_top_n);
+    std::cout << "Finished: Phrase queries processed." << std::endl;
+}
+
+void batchPrompt() {
+    std::cout << "Processing batch prompts..." << std::endl;
+    BATCH::processBatchPrompts(ENV_HPP::batch_prompt_path, ENV_HPP::batch_result_path);
+    std::cout << "Finished: Batch prompts processed." << std::endl;
+}
+
+void serve() {
+    std::cout << "Starting query server..." << std::endl;
+    SERVER::serve(ENV_HPP::socket_path);
+    std::cout << "Finished: Query server stopped." << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     // Get the current time for later time delta
     std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
@@ -59,16 +258,62 @@ int main(int argc, char* argv[]) {
     std::map<std::string, std::function<void()>> actions {
         {"--displayhelp", displayHelp},
         {"--computerelationaldistance", computeRelationalDistance},
+        {"--computerelationaldistancesketch", computeRelationalDistanceSketch},
         {"--updatedatabaseinformation", updateDatabaseInformation},
-        {"--processprompt", processPrompt}
+        {"--computeglobalterms", computeGlobalTerms},
+        {"--exportcolumnar", exportColumnar},
+        {"--benchmarkexport", benchmarkExport},
+        {"--ingestring", ingestRing},
+        {"--benchmarkring", benchmarkRing},
+        {"--generatecorpus", generateCorpus},
+        {"--benchmarkscaling", benchmarkScaling},
+        {"--processprompt", processPrompt},
+        {"--processpromptparallel", processPromptParallel},
+        {"--processpromptcsr", processPromptCSR},
+        {"--processpromptcosine", processPromptCosine},
+        {"--processpromptbm25", processPromptBM25},
+        {"--processprompttfidf", processPromptTfIdf},
+        {"--processpromptboolean", processPromptBoolean},
+        {"--processpromptfiltered", processPromptFiltered},
+        {"--processpromptfacets", processPromptFacets},
+        {"--benchmarkfacets", benchmarkFacets},
+        {"--benchmarkintersection", benchmarkIntersection},
+        {"--benchmarkscoring", benchmarkScoring},
+        {"--processpromptexpanded", processPromptExpanded},
+        {"--buildchunkindex", buildChunkIndex},
+        {"--buildimpactindex", buildImpactIndex},
+        {"--processpromptchunks", processPromptChunks},
+        {"--processprompttwostage", processPromptTwoStage},
+        {"--buildpositionalindex", buildPositionalIndex},
+        {"--processphrases", processPhrases},
+        {"--batchprompt", batchPrompt},
+        {"--serve", serve}
     };
 
+    // --trace <file> records spans of every action, wherever it appears on the command line
+    // --dataroot <dir> runs every action on another data root, such as one from --generatecorpus
+    std::filesystem::path trace_path;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg(argv[i]);
+        std::transform(arg.begin(), arg.end(), arg.begin(), ::tolower);
+        if (arg == "--trace") trace_path = argv[i + 1];
+        if (arg == "--dataroot") {
+            ENV_HPP::use_data_root(std::filesystem::absolute(argv[i + 1]));
+            // Synthetic roots carry their own PDFs
+            if (std::filesystem::exists(ENV_HPP::data_root / ("resources"))) ENV_HPP::resource_path = ENV_HPP::data_root / ("resources");
+        }
+    }
+    if (!trace_path.empty()) TRACE::start();
+
     // Iterate through the provided command-line arguments and execute corresponding actions
     for (int i = 1; i < argc; ++i) {
         std::string arg(argv[i]);
         std::transform(arg.begin(), arg.end(), arg.begin(), ::tolower);  // Normalize to lowercase
 
-        if (actions.find(arg) != actions.end()) {
+        if (arg == "--trace" || arg == "--dataroot") {
+            ++i;  // Skip the option's value
+        } else if (actions.find(arg) != actions.end()) {
+            METRICS::ScopedTimer action_timer(actions.find(arg)->first);  // Key of actions, so it outlives the report
             actions[arg]();  // Execute the corresponding function
         } else {
             std::cout << "Invalid option: " << arg << ". Please try again." << std::endl;
@@ -78,6 +323,13 @@ int main(int argc, char* argv[]) {
     std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
     std::cout << "Time elapsed: " << elapsed_seconds.count() << " seconds" << std::endl;
+
+    // Report where the time went, per action and per stage
+    METRICS::write_report(ENV_HPP::metrics_report_path, {
+        {"command", std::vector<std::string>(argv + 1, argv + argc)},
+        {"elapsed_seconds", elapsed_seconds.count()},
+    });
+    if (!trace_path.empty()) TRACE::write(trace_path);
     std::cout << "Finished program." << std::endl;
     return 0;
 }
@@ -0,0 +1,81 @@
+import json
+import mmap
+import struct
+
+# Reader for the columnar tables written by the C++ program (--exportcolumnar)
+FILE_MAGIC = 0x46434153  # "SACF"
+FILE_VERSION = 1
+
+def _decode_delta_varint(data: memoryview, count: int) -> list:
+    values = []
+    previous = 0
+    position = 0
+    for _ in range(count):
+        zigzag = 0
+        shift = 0
+        while True:
+            byte = data[position]
+            position += 1
+            zigzag |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                break
+        previous += (zigzag >> 1) ^ -(zigzag & 1)
+        values.append(previous)
+    return values
+
+def _integers(view: memoryview, column: dict, rows: int, format: str):
+    if column["compression"] == "none":
+        offset, size = column["values"]
+        # Uncompressed buffers are viewed in place, without copying
+        return view[offset:offset + size].cast(format)
+    values = []
+    for offset, size, count in column["blocks"]:
+        values.extend(_decode_delta_varint(view[offset:offset + size], count))
+    return values
+
+def read_table(file_path: str) -> dict:
+    """Map a columnar file and return {column name: values}.
+
+    int64 and float64 columns are memoryviews over the mapped file unless compressed;
+    dictionary columns are returned as (codes, dictionary) pairs.
+    """
+    with open(file_path, "rb") as f:
+        view = memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+
+    magic, version = struct.unpack_from("<II", view, 0)
+    footer_size, end_magic = struct.unpack_from("<QI", view, len(view) - 12)
+    if magic != FILE_MAGIC or end_magic != FILE_MAGIC or version != FILE_VERSION:
+        raise ValueError(f"Not a columnar file of version {FILE_VERSION}: {file_path}")
+    footer = json.loads(bytes(view[len(view) - 12 - footer_size:len(view) - 12]))
+
+    rows = footer["rows"]
+    table = {}
+    for column in footer["columns"]:
+        if column["type"] == "int64":
+            table[column["name"]] = _integers(view, column, rows, "q")
+        elif column["type"] == "float64":
+            offset, size = column["values"]
+            table[column["name"]] = view[offset:offset + size].cast("d")
+        else:
+            codes = _integers(view, column, rows, "i")
+            offset, size = column["dictionary_offsets"]
+            offsets = view[offset:offset + size].cast("i")
+            offset, size = column["dictionary_data"]
+            data = bytes(view[offset:offset + size])
+            dictionary = [data[offsets[i]:offsets[i + 1]].decode("utf-8") for i in range(column["dictionary_size"])]
+            table[column["name"]] = (codes, dictionary)
+    return table
+
+def read_dataframe(file_path: str):
+    """Load a columnar file into a pandas DataFrame, with dictionary columns as categoricals."""
+    import pandas as pd
+
+    columns = {}
+    for name, values in read_table(file_path).items():
+        if isinstance(values, tuple):
+            codes, dictionary = values
+            columns[name] = pd.Categorical.from_codes(list(codes), categories=dictionary)
+        else:
+            columns[name] = list(values)
+    return pd.DataFrame(columns)
@@ -0,0 +1,150 @@
+import ctypes
+import os
+
+# In-process access to the C++ engine through the shared library built from compileDLL.cpp
+ABI_VERSION = 1
+
+_c_strings = ctypes.POINTER(ctypes.c_char_p)
+
+def _declare(library: ctypes.CDLL) -> None:
+    library.study_abi_version.restype = ctypes.c_int32
+    library.study_last_error.restype = ctypes.c_char_p
+    library.study_index_open.argtypes = [ctypes.c_char_p]
+    library.study_index_open.restype = ctypes.c_void_p
+    library.study_index_close.argtypes = [ctypes.c_void_p]
+    library.study_index_close.restype = None
+    library.study_index_num_docs.argtypes = [ctypes.c_void_p]
+    library.study_index_num_docs.restype = ctypes.c_int64
+    library.study_index_generation.argtypes = [ctypes.c_void_p]
+    library.study_index_generation.restype = ctypes.c_int64
+    library.study_doc_id.argtypes = [ctypes.c_void_p, ctypes.c_int32]
+    library.study_doc_id.restype = ctypes.c_char_p
+    library.study_doc_name.argtypes = [ctypes.c_void_p, ctypes.c_int32]
+    library.study_doc_name.restype = ctypes.c_char_p
+    library.study_score_prompt.argtypes = [ctypes.c_void_p, _c_strings, ctypes.POINTER(ctypes.c_int32), ctypes.c_int32,
+                                           ctypes.c_int32, ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_double)]
+    library.study_score_prompt.restype = ctypes.c_int32
+    library.study_ingest_token_maps.argtypes = [ctypes.c_char_p, _c_strings, ctypes.POINTER(ctypes.c_int64), _c_strings,
+                                                ctypes.POINTER(ctypes.c_int32), ctypes.c_int32, ctypes.c_int32]
+    library.study_ingest_token_maps.restype = ctypes.c_int64
+    library.study_ring_attach.argtypes = [ctypes.c_char_p]
+    library.study_ring_attach.restype = ctypes.c_void_p
+    library.study_ring_close.argtypes = [ctypes.c_void_p]
+    library.study_ring_close.restype = None
+    library.study_ring_push_title.argtypes = [ctypes.c_void_p, ctypes.c_char_p, _c_strings, ctypes.POINTER(ctypes.c_int32),
+                                              ctypes.c_int32, ctypes.c_int32]
+    library.study_ring_push_title.restype = ctypes.c_int32
+    library.study_ring_finish.argtypes = [ctypes.c_void_p]
+    library.study_ring_finish.restype = ctypes.c_int32
+
+def _strings(values) -> ctypes.Array:
+    return (ctypes.c_char_p * len(values))(*[value.encode("utf-8") for value in values])
+
+class Engine:
+    """Wrapper over the shared library; raises RuntimeError with the library's message on failure."""
+
+    def __init__(self, library_path: str):
+        self.library = ctypes.CDLL(library_path)
+        _declare(self.library)
+        version = self.library.study_abi_version()
+        if version != ABI_VERSION:
+            raise RuntimeError(f"Engine ABI version {version}, expected {ABI_VERSION}")
+
+    def _error(self) -> RuntimeError:
+        return RuntimeError(self.library.study_last_error().decode("utf-8"))
+
+    def ingest_token_maps(self, database: str, token_maps: dict, reset_tables: bool = False) -> int:
+        """Insert {title name: {term: count}} into file_token and relation_distance in one transaction."""
+        names = list(token_maps)
+        offsets = [0]
+        terms = []
+        counts = []
+        for name in names:
+            for term, count in token_maps[name].items():
+                terms.append(term)
+                counts.append(count)
+            offsets.append(len(terms))
+        inserted = self.library.study_ingest_token_maps(database.encode("utf-8"), _strings(names),
+                                                        (ctypes.c_int64 * len(offsets))(*offsets), _strings(terms),
+                                                        (ctypes.c_int32 * len(counts))(*counts), len(names), int(reset_tables))
+        if inserted < 0:
+            raise self._error()
+        return inserted
+
+    def open_index(self, database: str) -> "TitleIndex":
+        return TitleIndex(self, database)
+
+    def attach_ring(self, name: str = "/study_ingest") -> "Ring":
+        return Ring(self, name)
+
+class TitleIndex:
+    """Title index held by the engine; score prompts with score(), release with close() or a with block."""
+
+    def __init__(self, engine: Engine, database: str):
+        self.library = engine.library
+        self.engine = engine
+        self.handle = self.library.study_index_open(database.encode("utf-8"))
+        if not self.handle:
+            raise engine._error()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def close(self) -> None:
+        if self.handle:
+            self.library.study_index_close(self.handle)
+            self.handle = None
+
+    def score(self, tokens: dict, top_n: int = 100) -> list:
+        """Score {term: count} and return (id, file name, score) tuples, best first."""
+        docs = (ctypes.c_int32 * top_n)()
+        scores = (ctypes.c_double * top_n)()
+        count = self.library.study_score_prompt(self.handle, _strings(list(tokens)),
+                                                (ctypes.c_int32 * len(tokens))(*tokens.values()), len(tokens),
+                                                top_n, docs, scores)
+        if count < 0:
+            raise self.engine._error()
+        return [(self.library.study_doc_id(self.handle, docs[i]).decode("utf-8"),
+                 self.library.study_doc_name(self.handle, docs[i]).decode("utf-8"),
+                 scores[i]) for i in range(count)]
+
+class Ring:
+    """Producer end of the shared memory ring read by --ingestring; call finish() once all titles are pushed."""
+
+    def __init__(self, engine: Engine, name: str):
+        self.library = engine.library
+        self.engine = engine
+        self.handle = self.library.study_ring_attach(name.encode("utf-8"))
+        if not self.handle:
+            raise engine._error()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def close(self) -> None:
+        if self.handle:
+            self.library.study_ring_close(self.handle)
+            self.handle = None
+
+    def push_title(self, name: str, tokens: dict, timeout_ms: int = -1) -> bool:
+        """Push {term: count} for one title; blocks while the consumer is behind, False on timeout."""
+        pushed = self.library.study_ring_push_title(self.handle, name.encode("utf-8"), _strings(list(tokens)),
+                                                    (ctypes.c_int32 * len(tokens))(*tokens.values()), len(tokens),
+                                                    timeout_ms)
+        if pushed < 0:
+            raise self.engine._error()
+        return pushed == 1
+
+    def finish(self) -> None:
+        if self.library.study_ring_finish(self.handle) < 0:
+            raise self.engine._error()
+
+def load_engine(library_path: str):
+    """Return an Engine, or None if the shared library has not been built."""
+    return Engine(library_path) if os.path.exists(library_path) else None
@@ -1,4 +1,4 @@
-from os import getcwd
+from os import getcwd, name
 
 StudyApp_root_path = getcwd() + "\\"
 
@@ -8,4 +8,14 @@ token_json_path = StudyApp_root_path + "data\\token_json"
 
 log_file_path = StudyApp_root_path + "data\\process.log"
 log_database_path = StudyApp_root_path + "data\\log_message.db"
-buffer_json_path = StudyApp_root_path + "data\\buffer.json"
\ No newline at end of file
+buffer_json_path = StudyApp_root_path + "data\\buffer.json"
+
+# Shared library built from compileDLL.cpp
+engine_library_path = StudyApp_root_path + ("study_engine.dll" if name == "nt" else "study_engine.so")
+
+# Same as ENV_HPP::default_top_n, so in-process scoring prints the results the executable prints
+default_top_n = 100
+# Titles handed to the engine library per ingest call, bounding the token maps held in memory
+engine_ingest_batch = 256
+# How long a ring push may wait for space before the consumer is presumed gone
+engine_ring_timeout_ms = 10000
\ No newline at end of file
@@ -4,11 +4,12 @@ import re
 import nltk
 from collections import defaultdict
 from shutil import rmtree
-from modules.path import chunk_database_path, token_json_path, buffer_json_path
+from modules.path import chunk_database_path, token_json_path, buffer_json_path, engine_library_path, default_top_n, engine_ingest_batch, engine_ring_timeout_ms
+from modules.engine import load_engine
 from nltk.stem import PorterStemmer
 from nltk.corpus import stopwords
 from concurrent.futures import ThreadPoolExecutor
-from json import dump
+from json import dump, load
 import string
 
 # One-time compiled regex pattern
@@ -97,6 +98,13 @@ def retrieve_token_list(title_id, database):
 
     return clean_text_dict
 
+# Attach to the shared memory ring when --ingestring is waiting for producers, otherwise return None
+def attach_ring(engine):
+    try:
+        return engine.attach_ring()
+    except RuntimeError:
+        return None
+
 # Process chunks in batches and store word frequencies in individual JSON files
 def process_chunks_in_batches(database):
     conn = sqlite3.connect(database)
@@ -104,33 +112,69 @@ def process_chunks_in_batches(database):
 
     fetched_result = get_title_ids(cursor)
     pdf_titles = list(fetched_result.keys())
-    global_word_freq = defaultdict(int)
 
     # Ensure the directory exists
     os.makedirs(token_json_path, exist_ok=True)
 
+    # With the engine library built, token maps are also ingested: over the shared memory ring when
+    # --ingestring is waiting, otherwise in-process, a bounded batch at a time
+    engine = load_engine(engine_library_path)
+    ring = attach_ring(engine) if engine else None
+    pushed_titles = []
+    token_maps = {}
+    ingested_titles = 0
+    inserted = 0
+
+    def ingest_batch():
+        nonlocal ingested_titles, inserted
+        # The first batch resets the tables, as --computerelationaldistance does
+        inserted += engine.ingest_token_maps(database, token_maps, reset_tables=(ingested_titles == 0))
+        ingested_titles += len(token_maps)
+        token_maps.clear()
+
+    def add_token_map(name, word_freq):
+        token_maps[name] = word_freq
+        if len(token_maps) >= engine_ingest_batch:
+            ingest_batch()
+
     # Process title IDs in parallel (each thread gets its own connection)
     with ThreadPoolExecutor(max_workers=4) as executor:
         for title_id, word_freq in zip(pdf_titles, executor.map(retrieve_token_list, pdf_titles, [database] * len(pdf_titles))):
 
-            # Update global word frequencies
-            for word, freq in word_freq.items():
-                global_word_freq[word] += freq
-
             # Dump word frequencies for each title into a separate JSON file immediately
             json_file_path = os.path.join(token_json_path, f'title_{fetched_result[title_id]}.json')
             with open(json_file_path, 'w', encoding='utf-8') as f:
                 dump(word_freq, f, ensure_ascii=False, indent=4)
+            name = f'title_{fetched_result[title_id]}'
+            if ring:
+                if ring.push_title(name, word_freq, timeout_ms=engine_ring_timeout_ms):
+                    pushed_titles.append(name)
+                    continue
+                # The ring stayed full, so the consumer stopped; ingest everything in-process instead
+                print(f"Shared memory ring timed out after {len(pushed_titles)} titles; ingesting in-process.")
+                ring.close()
+                ring = None
+                for pushed in pushed_titles:
+                    with open(os.path.join(token_json_path, f'{pushed}.json'), encoding='utf-8') as f:
+                        add_token_map(pushed, load(f))
+            if engine:
+                add_token_map(name, word_freq)
 
     print("All titles processed and word frequencies stored in individual JSON files.")
 
+    if ring:
+        ring.finish()
+        ring.close()
+        print(f"Pushed {len(pushed_titles)} titles to the shared memory ring.")
+    elif engine:
+        if token_maps or ingested_titles == 0:
+            ingest_batch()
+        print(f"Ingested {ingested_titles} titles ({inserted} relation_distance rows) through the engine library.")
+
     conn.commit()
     conn.close()
 
-    json_global_path = os.path.join(os.getcwd(), 'data', 'global_word_freq.json')
-    with open(json_global_path, 'w', encoding='utf-8') as f:
-        dump(global_word_freq, f, ensure_ascii=False, indent=4)
-    print("Global word frequencies inserted into the database.")
+    # Global term counts are computed from these files by the C++ program (--computeglobalterms)
 
 # Main function to process word frequencies in batches
 def process_word_frequencies_in_batches():
@@ -165,6 +209,13 @@ def promptFindingReference() -> None:
     with open(buffer_json_path, "w") as f:
         dump(cleaned_prompt, f, ensure_ascii=False, indent=4)
 
+    # Score in-process when the engine library is built, instead of launching the executable
+    engine = load_engine(engine_library_path)
+    if engine and cleaned_prompt:
+        with engine.open_index(chunk_database_path) as index:
+            for title_id, file_name, score in index.score(dict(cleaned_prompt), top_n=default_top_n):
+                print(f"ID: {title_id}\nDistance: {score}\nName: [[{file_name}.pdf]]")
+
 
 if __name__ == '__main__':
     print(banned_word)
\ No newline at end of file